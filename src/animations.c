@@ -1,8 +1,15 @@
 #include "animations.h"
 #include "ui.h"
+#include "profiler.h"
+#include "render_batch.h"
+#include "texture_registry.h"
 #include <SDL2/SDL.h>
 
 // Forward declarations of static functions
+static bool ensure_targets(UI* ui);
+static bool reclaim_targets(void* context, size_t bytes);
+static bool capture_screen(UI* ui, SDL_Texture* target);
+static AnimationType choose_effect(AnimationType type);
 static void animation_draw_fade(UI* ui);
 static void animation_draw_zoom(UI* ui);
 static void animation_draw_slide_left(UI* ui);
@@ -10,76 +17,187 @@ static void animation_draw_slide_right(UI* ui);
 
 void animation_start(UI* ui, AnimationType type) {
     ui->transition.type = type;
-    ui->transition.prev_screen = SDL_CreateTexture(ui->renderer,
-        SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
-        WINDOW_WIDTH, WINDOW_HEIGHT);
-        
-    ui->transition.next_screen = SDL_CreateTexture(ui->renderer,
-        SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
-        WINDOW_WIDTH, WINDOW_HEIGHT);
-        
+    ui->transition.effect = choose_effect(type);
     ui->transition.progress = 0.0f;
+    ui->transition.next_captured = false;
+
+    if (ui->transition.duration <= 0.0f) {
+        ui->transition.duration = TRANSITION_DURATION;
+    }
+
+    // Frames are already over budget, or no render targets: cut instead
+    if (ui->transition.effect == ANIM_NONE || !ensure_targets(ui) ||
+        !capture_screen(ui, ui->transition.prev_screen)) {
+        ui->animating = false;
+        ui_invalidate(ui, UI_DIRTY_ALL);
+        return;
+    }
+
     ui->transition.start_time = SDL_GetTicks();
+    ui->transition.last_frame = ui->transition.start_time;
     ui->animating = true;
+    ui_invalidate(ui, UI_DIRTY_ANIMATION);
 }
 
 void animation_update(UI* ui) {
     if (!ui->animating) return;
-    
+
     Uint32 current_time = SDL_GetTicks();
     float elapsed = (current_time - ui->transition.start_time) / 1000.0f;
     ui->transition.progress = elapsed / ui->transition.duration;
-    
+
+    // A composited frame that badly overran the budget ends the transition
+    if (current_time - ui->transition.last_frame > 2 * UI_FRAME_BUDGET_MS &&
+        ui->transition.next_captured) {
+        ui->transition.progress = 1.0f;
+    }
+    ui->transition.last_frame = current_time;
+
     if (ui->transition.progress >= 1.0f) {
         ui->transition.progress = 1.0f;
         ui->animating = false;
     }
-    
-    switch (ui->transition.type) {
+    ui_invalidate(ui, UI_DIRTY_ANIMATION);
+}
+
+void animation_draw(UI* ui) {
+    if (!ui->transition.next_captured) {
+        if (!capture_screen(ui, ui->transition.next_screen)) {
+            ui->animating = false;
+            ui_draw_screen(ui);
+            return;
+        }
+        ui->transition.next_captured = true;
+
+        // Time the transition from the first composited frame, so the
+        // capture itself is not counted as a slow frame
+        ui->transition.start_time = SDL_GetTicks();
+        ui->transition.last_frame = ui->transition.start_time;
+    }
+
+    switch (ui->transition.effect) {
         case ANIM_FADE:
             animation_draw_fade(ui);
             break;
-            
+
         case ANIM_ZOOM:
             animation_draw_zoom(ui);
             break;
-            
+
         case ANIM_SLIDE_LEFT:
             animation_draw_slide_left(ui);
             break;
-            
+
         case ANIM_SLIDE_RIGHT:
             animation_draw_slide_right(ui);
             break;
+
+        case ANIM_NONE:
+            break;
+    }
+}
+
+void animation_shutdown(UI* ui) {
+    texture_registry_set_reclaimer(TEXTURE_CLASS_TRANSITION, NULL, NULL);
+    texture_registry_destroy(ui->transition.prev_screen);
+    texture_registry_destroy(ui->transition.next_screen);
+    ui->transition.prev_screen = NULL;
+    ui->transition.next_screen = NULL;
+    ui->animating = false;
+}
+
+static bool ensure_targets(UI* ui) {
+    // Created once and reused by every transition, unless reclaimed
+    // between transitions to make room for other textures
+    texture_registry_set_reclaimer(TEXTURE_CLASS_TRANSITION, reclaim_targets, ui);
+    if (!ui->transition.prev_screen) {
+        ui->transition.prev_screen = texture_registry_create(ui->renderer,
+            TEXTURE_CLASS_TRANSITION, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+            WINDOW_WIDTH, WINDOW_HEIGHT);
+    }
+    if (!ui->transition.next_screen) {
+        ui->transition.next_screen = texture_registry_create(ui->renderer,
+            TEXTURE_CLASS_TRANSITION, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+            WINDOW_WIDTH, WINDOW_HEIGHT);
     }
+    return ui->transition.prev_screen && ui->transition.next_screen;
+}
+
+static bool reclaim_targets(void* context, size_t bytes) {
+    UI* ui = context;
+    (void)bytes;
+
+    // Both are in use from the first capture until the transition ends; a
+    // missing one means ensure_targets is still creating them
+    SDL_Texture* target = SDL_GetRenderTarget(ui->renderer);
+    if (ui->animating || !ui->transition.prev_screen || !ui->transition.next_screen ||
+        target == ui->transition.prev_screen || target == ui->transition.next_screen) {
+        return false;
+    }
+
+    texture_registry_destroy(ui->transition.prev_screen);
+    texture_registry_destroy(ui->transition.next_screen);
+    ui->transition.prev_screen = NULL;
+    ui->transition.next_screen = NULL;
+    return true;
+}
+
+static bool capture_screen(UI* ui, SDL_Texture* target) {
+    SDL_Texture* previous = SDL_GetRenderTarget(ui->renderer);
+    if (SDL_SetRenderTarget(ui->renderer, target) != 0) return false;
+
+    SDL_SetRenderDrawColor(ui->renderer, 0, 0, 0, 255);
+    SDL_RenderClear(ui->renderer);
+    ui_draw_screen(ui);
+
+    // Queued geometry must land in the target, not the next frame
+    render_batch_flush(ui->renderer);
+
+    SDL_SetRenderTarget(ui->renderer, previous);
+    return true;
+}
+
+static AnimationType choose_effect(AnimationType type) {
+    float frame_ms = profiler_percentile(PROFILER_PHASE_FRAME, 90);
+
+    // Over budget: no transition at all
+    if (frame_ms > UI_FRAME_BUDGET_MS) return ANIM_NONE;
+
+    // Close to budget: fade and zoom blend two full screens; an opaque
+    // slide only copies them
+    if (frame_ms > UI_FRAME_BUDGET_MS * 0.75f &&
+        (type == ANIM_FADE || type == ANIM_ZOOM)) {
+        return ANIM_SLIDE_LEFT;
+    }
+    return type;
 }
 
 static void animation_draw_fade(UI* ui) {
-    // Draw previous screen
-    SDL_SetTextureAlphaMod(ui->transition.prev_screen, 
-                          255 * (1.0f - ui->transition.progress));
+    // Previous screen stays opaque; the next one fades in over it
+    SDL_SetTextureBlendMode(ui->transition.prev_screen, SDL_BLENDMODE_NONE);
     SDL_RenderCopy(ui->renderer, ui->transition.prev_screen, NULL, NULL);
-    
-    // Draw next screen
+
+    SDL_SetTextureBlendMode(ui->transition.next_screen, SDL_BLENDMODE_BLEND);
     SDL_SetTextureAlphaMod(ui->transition.next_screen,
                           255 * ui->transition.progress);
     SDL_RenderCopy(ui->renderer, ui->transition.next_screen, NULL, NULL);
 }
 
 static void animation_draw_zoom(UI* ui) {
-    SDL_Rect src = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
     SDL_Rect dst = {
         WINDOW_WIDTH/2 * ui->transition.progress,
         WINDOW_HEIGHT/2 * ui->transition.progress,
         WINDOW_WIDTH * (1.0f - ui->transition.progress),
         WINDOW_HEIGHT * (1.0f - ui->transition.progress)
     };
-    
+
+    // Draw next screen behind the previous one
+    SDL_SetTextureBlendMode(ui->transition.next_screen, SDL_BLENDMODE_NONE);
+    SDL_RenderCopy(ui->renderer, ui->transition.next_screen, NULL, NULL);
+
     // Draw previous screen zooming out
+    SDL_SetTextureBlendMode(ui->transition.prev_screen, SDL_BLENDMODE_NONE);
     SDL_RenderCopy(ui->renderer, ui->transition.prev_screen, NULL, &dst);
-    
-    // Draw next screen behind it
-    SDL_RenderCopy(ui->renderer, ui->transition.next_screen, NULL, NULL);
 }
 
 static void animation_draw_slide_left(UI* ui) {
@@ -91,7 +209,9 @@ static void animation_draw_slide_left(UI* ui) {
         WINDOW_WIDTH * (1.0f - ui->transition.progress), 0,
         WINDOW_WIDTH, WINDOW_HEIGHT
     };
-    
+
+    SDL_SetTextureBlendMode(ui->transition.prev_screen, SDL_BLENDMODE_NONE);
+    SDL_SetTextureBlendMode(ui->transition.next_screen, SDL_BLENDMODE_NONE);
     SDL_RenderCopy(ui->renderer, ui->transition.prev_screen, NULL, &prev_rect);
     SDL_RenderCopy(ui->renderer, ui->transition.next_screen, NULL, &next_rect);
 }
@@ -105,7 +225,9 @@ static void animation_draw_slide_right(UI* ui) {
         -WINDOW_WIDTH * (1.0f - ui->transition.progress), 0,
         WINDOW_WIDTH, WINDOW_HEIGHT
     };
-    
+
+    SDL_SetTextureBlendMode(ui->transition.prev_screen, SDL_BLENDMODE_NONE);
+    SDL_SetTextureBlendMode(ui->transition.next_screen, SDL_BLENDMODE_NONE);
     SDL_RenderCopy(ui->renderer, ui->transition.prev_screen, NULL, &prev_rect);
     SDL_RenderCopy(ui->renderer, ui->transition.next_screen, NULL, &next_rect);
-} 
\ No newline at end of file
+}
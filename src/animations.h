@@ -4,7 +4,12 @@
 #include "ui.h"
 
 // Animation functions
+//
+// Call animation_start before changing state: it captures the outgoing
+// screen. The incoming screen is captured on the first composited frame.
 void animation_start(UI* ui, AnimationType type);
 void animation_update(UI* ui);
+void animation_draw(UI* ui);
+void animation_shutdown(UI* ui);
 
 #endif // ANIMATIONS_H 
\ No newline at end of file
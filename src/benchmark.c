@@ -0,0 +1,539 @@
+#include "benchmark.h"
+#include "ui.h"
+#include "animations.h"
+#include "categories.h"
+#include "filter_engine.h"
+#include "keyboard.h"
+#include "profiler.h"
+#include "render_batch.h"
+#include "search.h"
+#include "text_renderer.h"
+#include <SDL2/SDL_ttf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCHMARK_PAGE_FRAMES 8     // Frames between grid and guide pages
+#define BENCHMARK_KEY_FRAMES 6      // Frames between search keystrokes
+#define BENCHMARK_QUERY "sport 1"
+
+typedef enum {
+    BENCHMARK_VIEW_LIST,     // Drawn by ui_draw for the current state
+    BENCHMARK_VIEW_GRID,
+    BENCHMARK_VIEW_EPG
+} BenchmarkView;
+
+// Scripted step; input runs before each of its frames, frame 0 first
+typedef struct {
+    const char* name;
+    BenchmarkView view;
+    int frames;
+    void (*input)(UI* ui, int frame);
+} BenchmarkStep;
+
+// One measured frame
+typedef struct {
+    int step;
+    bool drawn;
+    float frame_ms;
+    float input_ms;
+    float update_ms;
+    float draw_ms;
+    Uint64 allocations;
+    Uint64 allocated_bytes;
+} BenchmarkFrame;
+
+static void scroll_down(UI* ui, int frame);
+static void scroll_up(UI* ui, int frame);
+static void page_grid(UI* ui, int frame);
+static void page_epg(UI* ui, int frame);
+static void type_search(UI* ui, int frame);
+static void idle(UI* ui, int frame);
+
+static const BenchmarkStep benchmark_steps[] = {
+    {"list_scroll_down", BENCHMARK_VIEW_LIST, 600, scroll_down},
+    {"list_scroll_up", BENCHMARK_VIEW_LIST, 600, scroll_up},
+    {"grid_page", BENCHMARK_VIEW_GRID, 480, page_grid},
+    {"epg_page", BENCHMARK_VIEW_EPG, 480, page_epg},
+    {"search_type", BENCHMARK_VIEW_LIST, 60, type_search},
+    {"search_idle", BENCHMARK_VIEW_LIST, 120, idle}
+};
+
+#define BENCHMARK_STEP_COUNT (int)(sizeof(benchmark_steps) / sizeof(benchmark_steps[0]))
+
+static const char* channel_words[] = {
+    "News", "Sport", "Movies", "Kids", "Music", "Docs", "Weather", "Cinema",
+    "Series", "Comedy", "Nature", "History"
+};
+
+static const char* program_words[] = {
+    "Morning Show", "Evening News", "Live Match", "Feature Film", "Cartoons",
+    "Top Hits", "Documentary", "Forecast", "Talk Show", "Quiz Night"
+};
+
+#define WORD_COUNT(words) (int)(sizeof(words) / sizeof(words[0]))
+
+#ifdef BENCHMARK_COUNT_ALLOCATIONS
+static Uint64 allocation_count;
+static Uint64 allocation_bytes;
+#endif
+
+static UI* create_ui(const char* font_path);
+static void destroy_ui(UI* ui);
+static Playlist* create_playlist(void);
+static void free_playlist(Playlist* playlist);
+static EPGData* create_epg(const Playlist* playlist, time_t start);
+static void free_epg(EPGData* epg);
+static void run_frame(UI* ui, const BenchmarkStep* step, int frame, BenchmarkFrame* out);
+static void draw_view(UI* ui, BenchmarkView view);
+static void push_button(SDL_GameControllerButton button);
+static void read_allocations(Uint64* count, Uint64* bytes);
+static bool write_frames(const char* filename, const BenchmarkFrame* frames, int count);
+static void print_summary(const BenchmarkFrame* frames, int count);
+static int compare_floats(const void* a, const void* b);
+
+bool benchmark_run(const char* font_path, const char* output_path) {
+    // Must be set before SDL picks a video driver
+    SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+    SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS) != 0) {
+        fprintf(stderr, "benchmark: %s\n", SDL_GetError());
+        return false;
+    }
+    if (TTF_Init() != 0) {
+        fprintf(stderr, "benchmark: %s\n", TTF_GetError());
+        SDL_Quit();
+        return false;
+    }
+
+    int total = 0;
+    for (int s = 0; s < BENCHMARK_STEP_COUNT; s++) {
+        total += benchmark_steps[s].frames;
+    }
+
+    bool ok = false;
+    UI* ui = create_ui(font_path);
+    BenchmarkFrame* frames = calloc(total, sizeof(BenchmarkFrame));
+    if (ui && frames) {
+        int index = 0;
+        for (int s = 0; s < BENCHMARK_STEP_COUNT; s++) {
+            for (int f = 0; f < benchmark_steps[s].frames; f++) {
+                frames[index].step = s;
+                run_frame(ui, &benchmark_steps[s], f, &frames[index]);
+                index++;
+            }
+        }
+
+        ok = write_frames(output_path, frames, total);
+        if (!ok) fprintf(stderr, "benchmark: could not write %s\n", output_path);
+        print_summary(frames, total);
+    }
+
+    free(frames);
+    destroy_ui(ui);
+    TTF_Quit();
+    SDL_Quit();
+    return ok;
+}
+
+#ifdef BENCHMARK_COUNT_ALLOCATIONS
+// Linked with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc; workers
+// allocate too, so the counters are shared between threads
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    __atomic_fetch_add(&allocation_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&allocation_bytes, size, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    __atomic_fetch_add(&allocation_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&allocation_bytes, count * size, __ATOMIC_RELAXED);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    __atomic_fetch_add(&allocation_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&allocation_bytes, size, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+#endif
+
+static void scroll_down(UI* ui, int frame) {
+    if (frame == 0) {
+        ui_set_state(ui, UI_STATE_PLAYLIST);
+        ui->selected_item = 0;
+        ui->scroll_offset = 0;
+    }
+    push_button(SDL_CONTROLLER_BUTTON_DPAD_DOWN);
+}
+
+static void scroll_up(UI* ui, int frame) {
+    (void)ui;
+    (void)frame;
+    push_button(SDL_CONTROLLER_BUTTON_DPAD_UP);
+}
+
+static void page_grid(UI* ui, int frame) {
+    // The grid has no UI state yet, so it is paged here as its input
+    // handler would, a screen of rows at a time
+    int rows = ((int)ui_visible_count(ui) + ui->grid_columns - 1) / ui->grid_columns;
+    if (frame == 0) {
+        ui->scroll_offset = 0;
+        ui->selected_item = 0;
+    } else if (frame % BENCHMARK_PAGE_FRAMES == 0) {
+        ui->scroll_offset += ui->grid_rows;
+        if (ui->scroll_offset >= rows) ui->scroll_offset = 0;
+        ui->selected_item = ui->scroll_offset * ui->grid_columns;
+    } else {
+        return;
+    }
+    ui_invalidate(ui, UI_DIRTY_INPUT);
+}
+
+static void page_epg(UI* ui, int frame) {
+    int rows = (WINDOW_HEIGHT - 140) / 60;
+    if (frame == 0) {
+        ui->scroll_offset = 0;
+    } else if (frame % BENCHMARK_PAGE_FRAMES == 0) {
+        ui->scroll_offset += rows;
+        if (ui->scroll_offset >= (int)ui_visible_count(ui)) ui->scroll_offset = 0;
+    } else {
+        return;
+    }
+    ui_invalidate(ui, UI_DIRTY_INPUT);
+}
+
+static void type_search(UI* ui, int frame) {
+    if (frame == 0) {
+        ui->selected_item = 0;
+        ui->scroll_offset = 0;
+        ui->keyboard.text[0] = '\0';
+        ui_set_state(ui, UI_STATE_SEARCH);
+    }
+
+    // Key events are not routed to the keyboard yet; press them directly
+    int key = frame / BENCHMARK_KEY_FRAMES;
+    if (frame % BENCHMARK_KEY_FRAMES == 0 && key < (int)strlen(BENCHMARK_QUERY)) {
+        keyboard_handle_keypress(ui, (SDL_Keycode)BENCHMARK_QUERY[key]);
+        ui_invalidate(ui, UI_DIRTY_INPUT);
+    }
+}
+
+static void idle(UI* ui, int frame) {
+    (void)ui;
+    (void)frame;
+}
+
+static UI* create_ui(const char* font_path) {
+    UI* ui = calloc(1, sizeof(UI));
+    if (!ui) return NULL;
+
+    ui->window = SDL_CreateWindow("IPTV Player benchmark", SDL_WINDOWPOS_UNDEFINED,
+                                  SDL_WINDOWPOS_UNDEFINED, WINDOW_WIDTH, WINDOW_HEIGHT,
+                                  SDL_WINDOW_HIDDEN);
+    if (ui->window) {
+        ui->renderer = SDL_CreateRenderer(ui->window, -1,
+                                          SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE);
+    }
+    if (!ui->renderer) {
+        fprintf(stderr, "benchmark: %s\n", SDL_GetError());
+        destroy_ui(ui);
+        return NULL;
+    }
+
+    ui->font = TTF_OpenFont(font_path, 24);
+    ui->font_large = TTF_OpenFont(font_path, 36);
+    if (!ui->font || !ui->font_large) {
+        fprintf(stderr, "benchmark: %s: %s\n", font_path, TTF_GetError());
+        destroy_ui(ui);
+        return NULL;
+    }
+
+    ui->state = UI_STATE_PLAYLIST;
+    ui->grid_rows = DEFAULT_GRID_ROWS;
+    ui->grid_columns = DEFAULT_GRID_COLS;
+    search_init(&ui->search);
+    keyboard_init(ui);
+
+    // Start the guide half a day back so the grid shows programs either side
+    // of now
+    time_t now = time(NULL);
+    ui->playlist = create_playlist();
+    if (ui->playlist) {
+        ui->epg = create_epg(ui->playlist, now - now % 1800 - BENCHMARK_EPG_SLOTS / 2 * 1800);
+    }
+    if (!ui->keyboard.text || !ui->playlist || !ui->epg) {
+        fprintf(stderr, "benchmark: out of memory\n");
+        destroy_ui(ui);
+        return NULL;
+    }
+
+    ui_update_categories(ui);
+    ui_invalidate(ui, UI_DIRTY_ALL);
+    return ui;
+}
+
+static void destroy_ui(UI* ui) {
+    if (!ui) return;
+
+    search_shutdown(ui);
+    ui_cleanup_thumbnails(ui);
+    animation_shutdown(ui);
+    text_renderer_shutdown();
+    render_batch_shutdown();
+
+    filter_engine_free(ui->filter_engine);
+    category_index_free(&ui->category_index);
+    for (int i = 0; i < ui->category_count; i++) {
+        free(ui->categories[i]);
+    }
+    free(ui->categories);
+
+    free(ui->keyboard.text);
+    free(ui->status_message);
+    free_epg(ui->epg);
+    free_playlist(ui->playlist);
+
+    if (ui->font) TTF_CloseFont(ui->font);
+    if (ui->font_large) TTF_CloseFont(ui->font_large);
+    if (ui->renderer) SDL_DestroyRenderer(ui->renderer);
+    if (ui->window) SDL_DestroyWindow(ui->window);
+    free(ui);
+}
+
+static Playlist* create_playlist(void) {
+    Playlist* playlist = playlist_create();
+    if (!playlist) return NULL;
+
+    // No logos: fetching them would make the run depend on the network
+    char name[64], url[96], group[32], id[32];
+    for (int i = 0; i < BENCHMARK_CHANNELS; i++) {
+        const char* word = channel_words[i % WORD_COUNT(channel_words)];
+        snprintf(name, sizeof(name), "%s %d HD", word, i);
+        snprintf(url, sizeof(url), "http://127.0.0.1/live/%d.ts", i);
+        snprintf(group, sizeof(group), "%s %d", word, i % BENCHMARK_GROUPS);
+        snprintf(id, sizeof(id), "channel%d", i);
+
+        PlaylistItem item = {0};
+        item.name = strdup(name);
+        item.title = item.name;
+        item.url = strdup(url);
+        item.group = strdup(group);
+        item.tvg_id = strdup(id);
+        if (!item.name || !item.url || !item.group || !item.tvg_id ||
+            !playlist_add_item(playlist, &item)) {
+            free(item.name);
+            free(item.url);
+            free(item.group);
+            free(item.tvg_id);
+            free_playlist(playlist);
+            return NULL;
+        }
+    }
+
+    return playlist;
+}
+
+static void free_playlist(Playlist* playlist) {
+    if (!playlist) return;
+
+    // playlist_free owns name, url, group and logo; title is name here
+    for (size_t i = 0; i < playlist->count; i++) {
+        free(playlist->items[i].tvg_id);
+    }
+    playlist_free(playlist);
+}
+
+static EPGData* create_epg(const Playlist* playlist, time_t start) {
+    EPGData* epg = epg_create();
+    if (!epg) return NULL;
+
+    epg->channels = calloc(playlist->count, sizeof(EPGProgramList));
+    if (!epg->channels) {
+        free(epg);
+        return NULL;
+    }
+    epg->channel_count = playlist->count;
+
+    char title[64];
+    for (size_t i = 0; i < playlist->count; i++) {
+        for (int slot = 0; slot < BENCHMARK_EPG_SLOTS; slot++) {
+            snprintf(title, sizeof(title), "%s %d",
+                     program_words[(i + slot) % WORD_COUNT(program_words)], slot);
+
+            EPGProgram program = {0};
+            program.title = strdup(title);
+            program.channel_id = strdup(playlist->items[i].tvg_id);
+            program.start_time = start + slot * 1800;
+            program.end_time = program.start_time + 1800;
+            if (!program.title || !program.channel_id ||
+                !epg_program_list_add(&epg->channels[i], &program)) {
+                epg_program_free(&program);
+                free_epg(epg);
+                return NULL;
+            }
+        }
+    }
+
+    return epg;
+}
+
+static void free_epg(EPGData* epg) {
+    if (!epg) return;
+
+    // epg_free frees each list as if allocated on its own; these share one
+    // array
+    for (size_t i = 0; i < epg->channel_count; i++) {
+        EPGProgramList* list = &epg->channels[i];
+        for (size_t p = 0; p < list->program_count; p++) {
+            epg_program_free(&list->programs[p]);
+        }
+        free(list->programs);
+    }
+    free(epg->channels);
+    free(epg);
+}
+
+static void run_frame(UI* ui, const BenchmarkStep* step, int frame, BenchmarkFrame* out) {
+    // Same phases as ui_run, without waiting for input between frames
+    double ms_per_tick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    Uint64 allocations, bytes;
+    read_allocations(&allocations, &bytes);
+
+    profiler_begin_frame();
+    Uint64 frame_start = profiler_begin();
+
+    Uint64 start = profiler_begin();
+    step->input(ui, frame);
+    ui_handle_input(ui);
+    profiler_end(PROFILER_PHASE_INPUT, start);
+    out->input_ms = (float)((profiler_begin() - start) * ms_per_tick);
+
+    start = profiler_begin();
+    ui_update(ui);
+    profiler_end(PROFILER_PHASE_UPDATE, start);
+    out->update_ms = (float)((profiler_begin() - start) * ms_per_tick);
+
+    out->drawn = ui->dirty != UI_DIRTY_NONE;
+    if (out->drawn) {
+        ui->dirty = UI_DIRTY_NONE;
+        start = profiler_begin();
+        draw_view(ui, step->view);
+        profiler_end(PROFILER_PHASE_DRAW, start);
+        out->draw_ms = (float)((profiler_begin() - start) * ms_per_tick);
+    }
+
+    profiler_end_frame(out->drawn);
+    out->frame_ms = (float)((profiler_begin() - frame_start) * ms_per_tick);
+
+    Uint64 allocations_after, bytes_after;
+    read_allocations(&allocations_after, &bytes_after);
+    out->allocations = allocations_after - allocations;
+    out->allocated_bytes = bytes_after - bytes;
+}
+
+static void draw_view(UI* ui, BenchmarkView view) {
+    if (view == BENCHMARK_VIEW_LIST) {
+        ui_draw(ui);
+        return;
+    }
+
+    // Grid and guide are drawn the way ui_draw draws a state
+    SDL_SetRenderDrawColor(ui->renderer, 0, 0, 0, 255);
+    SDL_RenderClear(ui->renderer);
+
+    Uint64 start = profiler_begin();
+    if (view == BENCHMARK_VIEW_GRID) {
+        ui_draw_grid(ui);
+    } else {
+        ui_draw_epg_grid(ui);
+    }
+    profiler_end(PROFILER_PHASE_DRAW_STATE, start);
+
+    render_batch_flush(ui->renderer);
+
+    start = profiler_begin();
+    SDL_RenderPresent(ui->renderer);
+    profiler_end(PROFILER_PHASE_PRESENT, start);
+}
+
+static void push_button(SDL_GameControllerButton button) {
+    SDL_Event event = {0};
+    event.type = SDL_CONTROLLERBUTTONDOWN;
+    event.cbutton.button = (Uint8)button;
+    event.cbutton.state = SDL_PRESSED;
+    SDL_PushEvent(&event);
+}
+
+static void read_allocations(Uint64* count, Uint64* bytes) {
+#ifdef BENCHMARK_COUNT_ALLOCATIONS
+    *count = __atomic_load_n(&allocation_count, __ATOMIC_RELAXED);
+    *bytes = __atomic_load_n(&allocation_bytes, __ATOMIC_RELAXED);
+#else
+    *count = 0;
+    *bytes = 0;
+#endif
+}
+
+static bool write_frames(const char* filename, const BenchmarkFrame* frames, int count) {
+    FILE* file = fopen(filename, "w");
+    if (!file) return false;
+
+    fprintf(file, "frame,step,drawn,frame_ms,input_ms,update_ms,draw_ms,"
+                  "allocations,allocated_bytes\n");
+    for (int i = 0; i < count; i++) {
+        const BenchmarkFrame* frame = &frames[i];
+        fprintf(file, "%d,%s,%d,%.3f,%.3f,%.3f,%.3f,%llu,%llu\n", i,
+                benchmark_steps[frame->step].name, frame->drawn ? 1 : 0,
+                frame->frame_ms, frame->input_ms, frame->update_ms, frame->draw_ms,
+                (unsigned long long)frame->allocations,
+                (unsigned long long)frame->allocated_bytes);
+    }
+
+    return fclose(file) == 0;
+}
+
+static void print_summary(const BenchmarkFrame* frames, int count) {
+    float* times = malloc(count * sizeof(float));
+    if (!times) return;
+
+    printf("%-18s %6s %6s %8s %8s %8s %12s\n", "step", "frames", "drawn",
+           "p50 ms", "p95 ms", "max ms", "allocs/frame");
+
+    for (int s = 0; s < BENCHMARK_STEP_COUNT; s++) {
+        // Percentiles over drawn frames, as the profiler keeps them
+        int steps = 0, drawn = 0;
+        Uint64 allocations = 0;
+        for (int i = 0; i < count; i++) {
+            if (frames[i].step != s) continue;
+            steps++;
+            allocations += frames[i].allocations;
+            if (frames[i].drawn) times[drawn++] = frames[i].frame_ms;
+        }
+        if (steps == 0) continue;
+
+        float p50 = 0, p95 = 0, max = 0;
+        if (drawn > 0) {
+            qsort(times, drawn, sizeof(float), compare_floats);
+            p50 = times[(int)(0.50f * (drawn - 1) + 0.5f)];
+            p95 = times[(int)(0.95f * (drawn - 1) + 0.5f)];
+            max = times[drawn - 1];
+        }
+
+        printf("%-18s %6d %6d %8.2f %8.2f %8.2f %12.1f\n", benchmark_steps[s].name,
+               steps, drawn, p50, p95, max, (double)allocations / steps);
+    }
+
+    free(times);
+}
+
+static int compare_floats(const void* a, const void* b) {
+    float fa = *(const float*)a;
+    float fb = *(const float*)b;
+    return fa < fb ? -1 : fa > fb;
+}
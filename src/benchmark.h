@@ -0,0 +1,30 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <stdbool.h>
+
+#define BENCHMARK_FONT "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf"
+#define BENCHMARK_OUTPUT "benchmark.csv"
+#define BENCHMARK_CHANNELS 5000     // Synthetic playlist size
+#define BENCHMARK_GROUPS 40
+#define BENCHMARK_EPG_SLOTS 48      // Half-hour programs per channel, a day
+
+// Headless UI benchmark
+//
+// Runs the UI on the SDL dummy video driver with the software renderer, so
+// it needs no display or GPU. A synthetic playlist and guide are generated,
+// then a fixed script replays input against them: scrolling the list,
+// paging the grid and the guide, and typing a search. Every frame is run
+// back to back, without the idle wait of ui_run, and timed per phase.
+//
+// Frames are written to output_path as CSV, one row each, and a summary
+// per step goes to stdout. Builds with BENCHMARK_COUNT_ALLOCATIONS and the
+// linker wrapping malloc, calloc and realloc also count the heap allocations
+// made by the application itself each frame; libraries linked as shared
+// objects are not seen.
+//
+// The compat layer in src/compat stands in for libnx on the host; see the
+// UI_BENCHMARK option in CMakeLists.txt.
+bool benchmark_run(const char* font_path, const char* output_path);
+
+#endif // BENCHMARK_H
@@ -1,11 +1,25 @@
 #include "categories.h"
 #include "ui.h"
 #include "playlist.h"
+#include "drawing.h"
+#include "filter_engine.h"
+#include "list_view.h"
+#include "hash.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-static void update_category_list(UI* ui);
-static bool add_category_if_new(UI* ui, const char* category);
+#define CATEGORY_INITIAL_CAPACITY 64
+#define CATEGORY_INITIAL_SLOTS 128
+
+static bool grow_slots(CategoryIndex* index, size_t new_count);
+static uint32_t* find_slot(const CategoryIndex* index, char** names,
+                           const char* name, uint32_t hash);
+static int compare_category_ids(const void* a, const void* b);
+static const char* category_label(UI* ui, int index, char* buffer, size_t size);
+
+// Names the id comparator sorts by
+static char** sort_names;
 
 void ui_update_categories(UI* ui) {
     if (!ui || !ui->playlist) return;
@@ -17,72 +31,285 @@ void ui_update_categories(UI* ui) {
     free(ui->categories);
     ui->categories = NULL;
     ui->category_count = 0;
+    category_index_free(&ui->category_index);
+    
+    CategoryIndex* index = &ui->category_index;
+    Playlist* playlist = ui->playlist;
+    size_t capacity = CATEGORY_INITIAL_CAPACITY;
+    char** names = malloc(capacity * sizeof(char*));
+    uint32_t* hashes = malloc(capacity * sizeof(uint32_t));
+    uint32_t* counts = calloc(capacity, sizeof(uint32_t));
+    if (!names || !hashes || !counts || !grow_slots(index, CATEGORY_INITIAL_SLOTS)) {
+        free(names);
+        free(hashes);
+        free(counts);
+        category_index_free(index);
+        return;
+    }
+    index->hashes = hashes;
+    
+    // One pass: intern each group name and count its items
+    uint32_t count = 0;
+    size_t i = 0;
+    for (; i < playlist->count; i++) {
+        PlaylistItem* item = &playlist->items[i];
+        item->group_id = CATEGORY_NONE;
+        if (!item->group || !item->group[0]) continue;
+        
+        uint32_t hash = hash_string32(item->group);
+        uint32_t* slot = find_slot(index, names, item->group, hash);
+        uint32_t id;
+        
+        if (*slot) {
+            id = *slot - 1;
+        } else {
+            if (count == capacity) {
+                capacity *= 2;
+                char** new_names = realloc(names, capacity * sizeof(char*));
+                if (new_names) names = new_names;
+                uint32_t* new_hashes = realloc(index->hashes, capacity * sizeof(uint32_t));
+                if (new_hashes) index->hashes = new_hashes;
+                uint32_t* new_counts = realloc(counts, capacity * sizeof(uint32_t));
+                if (new_counts) counts = new_counts;
+                if (!new_names || !new_hashes || !new_counts) break;
+            }
+            
+            names[count] = strdup(item->group);
+            if (!names[count]) break;
+            
+            id = count++;
+            index->hashes[id] = hash;
+            counts[id] = 0;
+            *slot = id + 1;
+            
+            // Keep the table at most half full
+            if (count * 2 > index->slot_count && !grow_slots(index, index->slot_count * 2)) {
+                count--;
+                free(names[id]);
+                *slot = 0;
+                break;
+            }
+        }
+        
+        item->group_id = id;
+        counts[id]++;
+    }
+    
+    // Out of memory part way through: the rest stays uncategorized
+    for (; i < playlist->count; i++) {
+        playlist->items[i].group_id = CATEGORY_NONE;
+    }
+    
+    // Renumber ids alphabetically so they match positions in ui->categories
+    uint32_t* order = malloc((count + 1) * sizeof(uint32_t));
+    uint32_t* remap = malloc((count + 1) * sizeof(uint32_t));
+    uint32_t* sorted_hashes = malloc((count + 1) * sizeof(uint32_t));
+    char** sorted_names = malloc((count + 1) * sizeof(char*));
+    index->offsets = malloc((count + 1) * sizeof(uint32_t));
+    if (!order || !remap || !sorted_hashes || !sorted_names || !index->offsets) {
+        for (uint32_t c = 0; c < count; c++) free(names[c]);
+        free(names);
+        free(counts);
+        free(order);
+        free(remap);
+        free(sorted_hashes);
+        free(sorted_names);
+        category_index_free(index);
+        for (i = 0; i < playlist->count; i++) {
+            playlist->items[i].group_id = CATEGORY_NONE;
+        }
+        return;
+    }
+    
+    for (uint32_t c = 0; c < count; c++) order[c] = c;
+    sort_names = names;
+    qsort(order, count, sizeof(uint32_t), compare_category_ids);
+    sort_names = NULL;
     
-    // Collect unique categories
-    for (size_t i = 0; i < ui->playlist->count; i++) {
-        PlaylistItem* item = &ui->playlist->items[i];
-        if (item->group && strlen(item->group) > 0) {
-            add_category_if_new(ui, item->group);
+    uint32_t total = 0;
+    for (uint32_t c = 0; c < count; c++) {
+        uint32_t old_id = order[c];
+        remap[old_id] = c;
+        sorted_names[c] = names[old_id];
+        sorted_hashes[c] = index->hashes[old_id];
+        index->offsets[c] = total;
+        total += counts[old_id];
+    }
+    index->offsets[count] = total;
+    index->item_count = total;
+    
+    for (size_t s = 0; s < index->slot_count; s++) {
+        if (index->slots[s]) index->slots[s] = remap[index->slots[s] - 1] + 1;
+    }
+    
+    // Fill the per-category item lists; playlist order is kept within each.
+    // Without the lists the ids are still remapped to match ui->categories.
+    index->items = malloc((total + 1) * sizeof(uint32_t));
+    if (index->items) {
+        memcpy(counts, index->offsets, count * sizeof(uint32_t));
+    }
+    for (i = 0; i < playlist->count; i++) {
+        PlaylistItem* item = &playlist->items[i];
+        if (item->group_id == CATEGORY_NONE) continue;
+        
+        item->group_id = remap[item->group_id];
+        if (index->items) {
+            index->items[counts[item->group_id]++] = (uint32_t)i;
         }
     }
     
-    // Sort categories alphabetically
-    if (ui->category_count > 1) {
-        qsort(ui->categories, ui->category_count, sizeof(char*), 
-              (int (*)(const void*, const void*))strcmp);
+    free(index->hashes);
+    index->hashes = sorted_hashes;
+    free(names);
+    free(counts);
+    free(order);
+    free(remap);
+    
+    ui->categories = sorted_names;
+    ui->category_count = (int)count;
+    
+    // Category ids changed; recompute the per-item filter bitmaps
+    ui_rebuild_filters(ui);
+}
+
+int ui_find_category(const UI* ui, const char* name) {
+    if (!ui || !name || !ui->categories || !ui->category_index.slots) return -1;
+    
+    uint32_t id = *find_slot(&ui->category_index, ui->categories, name, hash_string32(name));
+    return id ? (int)(id - 1) : -1;
+}
+
+uint32_t ui_category_items(const UI* ui, int category, const uint32_t** items) {
+    const CategoryIndex* index = &ui->category_index;
+    if (category < 0 || category >= ui->category_count || !index->items) {
+        *items = NULL;
+        return 0;
     }
+    
+    *items = &index->items[index->offsets[category]];
+    return index->offsets[category + 1] - index->offsets[category];
 }
 
-static bool add_category_if_new(UI* ui, const char* category) {
-    // Check if category already exists
-    for (int i = 0; i < ui->category_count; i++) {
-        if (strcmp(ui->categories[i], category) == 0) {
-            return false;
-        }
+bool ui_block_category(UI* ui, int category) {
+    if (!ui || !ui->category_filter || category < 0 || category >= ui->category_count) {
+        return false;
     }
     
-    // Add new category
-    char** new_categories = realloc(ui->categories, 
-                                  (ui->category_count + 1) * sizeof(char*));
-    if (!new_categories) return false;
+    CategoryFilter* filter = ui->category_filter;
+    if (!category_filter_add(filter, ui->categories[category])) return false;
     
-    ui->categories = new_categories;
-    ui->categories[ui->category_count] = strdup(category);
-    if (!ui->categories[ui->category_count]) return false;
+    if (filter->blocked_ids.bit_count != (size_t)ui->category_count &&
+        !category_filter_resolve(filter, ui)) {
+        return false;
+    }
+    item_bitmap_set(&filter->blocked_ids, (uint32_t)category);
     
-    ui->category_count++;
+    // Only this category's items change; they show again if the filter is off
+    if (ui->filter_engine) {
+        filter_engine_set_category_blocked(ui->filter_engine, (uint32_t)category, true);
+    }
     return true;
 }
 
+bool ui_unblock_category(UI* ui, int category) {
+    if (!ui || !ui->category_filter || category < 0 || category >= ui->category_count) {
+        return false;
+    }
+    
+    CategoryFilter* filter = ui->category_filter;
+    if (!category_filter_remove(filter, ui->categories[category])) return false;
+    
+    if ((size_t)category < filter->blocked_ids.bit_count) {
+        item_bitmap_reset(&filter->blocked_ids, (uint32_t)category);
+    }
+    
+    if (ui->filter_engine) {
+        filter_engine_set_category_blocked(ui->filter_engine, (uint32_t)category, false);
+    }
+    return true;
+}
+
+void ui_clear_blocked_categories(UI* ui) {
+    if (!ui || !ui->category_filter) return;
+    
+    // Unblock category by category so only blocked items are revisited
+    CategoryFilter* filter = ui->category_filter;
+    for (int c = 0; c < ui->category_count && filter->blocked_count > 0; c++) {
+        if ((size_t)c < filter->blocked_ids.bit_count &&
+            item_bitmap_test(&filter->blocked_ids, (uint32_t)c)) {
+            ui_unblock_category(ui, c);
+        }
+    }
+    
+    // Names that matched no category in this playlist
+    category_filter_clear(filter);
+}
+
+void category_index_free(CategoryIndex* index) {
+    free(index->offsets);
+    free(index->items);
+    free(index->hashes);
+    free(index->slots);
+    memset(index, 0, sizeof(CategoryIndex));
+}
+
 void ui_draw_categories(UI* ui) {
     if (!ui || !ui->categories) return;
     
-    // Draw category list
-    int y = 60;
+    // Only the rows on screen are formatted and drawn
+    ListView* view = &ui->category_view;
+    list_view_layout(view, 20, 60, WINDOW_WIDTH - 40, WINDOW_HEIGHT - 120, ITEM_HEIGHT);
+    list_view_follow(view, ui->selected_category, ui->category_count);
+    list_view_draw(view, ui, ui->category_count, ui->selected_category, category_label);
+    
     SDL_Color white = {255, 255, 255, 255};
+    draw_text(ui->renderer, ui->font, "A: Show Category   B: All Channels",
+              WINDOW_WIDTH/2, WINDOW_HEIGHT - 30, white, true);
+}
+
+static const char* category_label(UI* ui, int index, char* buffer, size_t size) {
+    // Item counts come straight from the category index
+    const uint32_t* items;
+    snprintf(buffer, size, "%s (%u)", ui->categories[index],
+             ui_category_items(ui, index, &items));
+    return buffer;
+}
+
+static uint32_t* find_slot(const CategoryIndex* index, char** names,
+                           const char* name, uint32_t hash) {
+    size_t mask = index->slot_count - 1;
+    size_t pos = hash & mask;
     
-    for (int i = 0; i < ui->category_count; i++) {
-        SDL_Color color = white;
-        if (i == ui->selected_category) {
-            color.r = 255;
-            color.g = 255;
-            color.b = 0;
-        }
+    // Linear probing; names are compared only when the full hash matches
+    while (index->slots[pos]) {
+        uint32_t id = index->slots[pos] - 1;
+        if (index->hashes[id] == hash && strcmp(names[id], name) == 0) break;
+        pos = (pos + 1) & mask;
+    }
+    return &index->slots[pos];
+}
+
+static bool grow_slots(CategoryIndex* index, size_t new_count) {
+    uint32_t* slots = calloc(new_count, sizeof(uint32_t));
+    if (!slots) return false;
+    
+    // Reinsert existing ids by their stored hashes
+    size_t mask = new_count - 1;
+    for (size_t s = 0; s < index->slot_count; s++) {
+        uint32_t entry = index->slots[s];
+        if (!entry) continue;
         
-        SDL_Surface* text = TTF_RenderText_Blended(ui->font, ui->categories[i], color);
-        if (text) {
-            SDL_Texture* texture = SDL_CreateTextureFromSurface(ui->renderer, text);
-            if (texture) {
-                SDL_Rect dst = {
-                    20,
-                    y + i * 40,
-                    text->w,
-                    text->h
-                };
-                SDL_RenderCopy(ui->renderer, texture, NULL, &dst);
-                SDL_DestroyTexture(texture);
-            }
-            SDL_FreeSurface(text);
-        }
+        size_t pos = index->hashes[entry - 1] & mask;
+        while (slots[pos]) pos = (pos + 1) & mask;
+        slots[pos] = entry;
     }
-} 
\ No newline at end of file
+    
+    free(index->slots);
+    index->slots = slots;
+    index->slot_count = new_count;
+    return true;
+}
+
+static int compare_category_ids(const void* a, const void* b) {
+    return strcmp(sort_names[*(const uint32_t*)a], sort_names[*(const uint32_t*)b]);
+}
@@ -3,32 +3,81 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include "ui_constants.h"
+#include "result_set.h"
+#include "playlist.h"
 
 // Forward declarations
 struct UI;
 typedef struct UI UI;
 
+#define CATEGORY_NONE UINT32_MAX
+
 // Category filter structure
+//
+// Blocked names are the persistent state; blocked_ids mirrors them as a bit
+// per dense category id so item checks are a single bit test. The ids are
+// re-resolved by category_filter_resolve whenever the category list changes.
 typedef struct CategoryFilter {
     char** blocked_categories;
     size_t blocked_count;
+    size_t blocked_capacity;
+    ItemBitmap blocked_ids;
     bool filter_active;
 } CategoryFilter;
 
+// Category index
+//
+// Built in one pass over the playlist. Group names are interned through an
+// open-addressing hash table into dense ids that match positions in
+// ui->categories (alphabetical). Items of category c are
+// items[offsets[c] .. offsets[c + 1]), in playlist order, so switching
+// categories is a pointer swap instead of a filter over every item.
+typedef struct {
+    uint32_t* offsets;      // category_count + 1 entries
+    uint32_t* items;        // Item indices grouped by category
+    uint32_t* hashes;       // Name hash per category id
+    uint32_t* slots;        // Hash table of category id + 1, 0 = empty
+    size_t slot_count;
+    size_t item_count;      // Items with a category
+} CategoryIndex;
+
 // Category filter functions
 CategoryFilter* category_filter_create(void);
 void category_filter_free(CategoryFilter* filter);
 bool category_filter_add(CategoryFilter* filter, const char* category);
 bool category_filter_remove(CategoryFilter* filter, const char* category);
 bool category_filter_is_blocked(const CategoryFilter* filter, const char* category);
+bool category_filter_resolve(CategoryFilter* filter, const UI* ui);
 void category_filter_clear(CategoryFilter* filter);
-void category_filter_enable(CategoryFilter* filter);
-void category_filter_disable(CategoryFilter* filter);
+void category_filter_enable(CategoryFilter* filter, UI* ui);
+void category_filter_disable(CategoryFilter* filter, UI* ui);
 bool category_filter_is_enabled(const CategoryFilter* filter);
 
+// Blocked in the list, whether or not the filter is on
+static inline bool category_filter_has_id(const CategoryFilter* filter, uint32_t id) {
+    return filter && id < filter->blocked_ids.bit_count &&
+           item_bitmap_test(&filter->blocked_ids, id);
+}
+
+static inline bool category_filter_is_blocked_id(const CategoryFilter* filter, uint32_t id) {
+    return filter && filter->filter_active && category_filter_has_id(filter, id);
+}
+
+static inline bool category_filter_blocks_item(const CategoryFilter* filter,
+                                               const PlaylistItem* item) {
+    return category_filter_is_blocked_id(filter, item->group_id);
+}
+
 // Category management functions
 void ui_update_categories(UI* ui);
+int ui_find_category(const UI* ui, const char* name);
+uint32_t ui_category_items(const UI* ui, int category, const uint32_t** items);
+void category_index_free(CategoryIndex* index);
+bool ui_block_category(UI* ui, int category);
+bool ui_unblock_category(UI* ui, int category);
+void ui_clear_blocked_categories(UI* ui);
 void ui_draw_categories(UI* ui);
 
 #endif // CATEGORIES_H 
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "ui.h"
 #include "ui_constants.h"
 #include "categories.h"
+#include "drawing.h"
+#include "render_batch.h"
 #include <SDL2/SDL_ttf.h>
 
 static void draw_menu(UI* ui);
@@ -52,6 +54,9 @@ void category_blocker_handle_input(UI* ui, SDL_Event* event) {
 void category_blocker_draw(UI* ui) {
     if (!ui->blocker.active) return;
     
+    // Everything queued so far belongs under the overlay
+    render_batch_flush(ui->renderer);
+    
     // Draw semi-transparent background
     SDL_SetRenderDrawBlendMode(ui->renderer, SDL_BLENDMODE_BLEND);
     SDL_SetRenderDrawColor(ui->renderer, 0, 0, 0, 192);
@@ -88,36 +93,23 @@ static void draw_menu(UI* ui) {
         }
         
         // Draw option text
-        SDL_Surface* text = TTF_RenderText_Blended(ui->font, options[i], color);
-        if (text) {
-            SDL_Texture* texture = SDL_CreateTextureFromSurface(ui->renderer, text);
-            if (texture) {
-                SDL_Rect dst = {
-                    menu_x + 10,
-                    menu_y + 10 + i * 40,
-                    text->w,
-                    text->h
-                };
-                SDL_RenderCopy(ui->renderer, texture, NULL, &dst);
-                SDL_DestroyTexture(texture);
-            }
-            SDL_FreeSurface(text);
-        }
+        draw_text(ui->renderer, ui->font, options[i],
+                  menu_x + 10, menu_y + 10 + i * 40, color, false);
     }
 }
 
 static void handle_menu_selection(UI* ui) {
     switch (ui->blocker.menu_selection) {
         case MENU_BLOCK:
-            // Show category selection dialog
+            ui_block_category(ui, ui->selected_category);
             break;
             
         case MENU_UNBLOCK:
-            // Show blocked categories list
+            ui_unblock_category(ui, ui->selected_category);
             break;
             
         case MENU_CLEAR:
-            category_filter_clear(ui->category_filter);
+            ui_clear_blocked_categories(ui);
             break;
             
         case MENU_BACK:
@@ -1,18 +1,25 @@
 #include "categories.h"
+#include "filter_engine.h"
+#include "ui.h"
 #include <stdlib.h>
 #include <string.h>
 
+static int find_blocked_name(const CategoryFilter* filter, const char* category);
+
 CategoryFilter* category_filter_create(void) {
     CategoryFilter* filter = malloc(sizeof(CategoryFilter));
     if (!filter) return NULL;
     
+    // Initial size only; the list grows as categories are blocked
     filter->blocked_categories = calloc(MAX_BLOCKED_CATEGORIES, sizeof(char*));
-    if (!filter->blocked_categories) {
+    if (!filter->blocked_categories || !item_bitmap_init(&filter->blocked_ids, 0)) {
+        free(filter->blocked_categories);
         free(filter);
         return NULL;
     }
     
     filter->blocked_count = 0;
+    filter->blocked_capacity = MAX_BLOCKED_CATEGORIES;
     filter->filter_active = false;
     
     return filter;
@@ -25,19 +32,23 @@ void category_filter_free(CategoryFilter* filter) {
         free(filter->blocked_categories[i]);
     }
     free(filter->blocked_categories);
+    item_bitmap_free(&filter->blocked_ids);
     free(filter);
 }
 
 bool category_filter_add(CategoryFilter* filter, const char* category) {
-    if (!filter || !category || filter->blocked_count >= MAX_BLOCKED_CATEGORIES) {
-        return false;
-    }
+    if (!filter || !category) return false;
     
     // Check if category is already blocked
-    for (size_t i = 0; i < filter->blocked_count; i++) {
-        if (strcmp(filter->blocked_categories[i], category) == 0) {
-            return true;  // Already blocked
-        }
+    if (find_blocked_name(filter, category) >= 0) return true;
+    
+    if (filter->blocked_count == filter->blocked_capacity) {
+        size_t capacity = filter->blocked_capacity * 2;
+        char** blocked = realloc(filter->blocked_categories, capacity * sizeof(char*));
+        if (!blocked) return false;
+        
+        filter->blocked_categories = blocked;
+        filter->blocked_capacity = capacity;
     }
     
     // Add new category
@@ -51,33 +62,35 @@ bool category_filter_add(CategoryFilter* filter, const char* category) {
 bool category_filter_remove(CategoryFilter* filter, const char* category) {
     if (!filter || !category) return false;
     
-    for (size_t i = 0; i < filter->blocked_count; i++) {
-        if (strcmp(filter->blocked_categories[i], category) == 0) {
-            free(filter->blocked_categories[i]);
-            
-            // Move remaining categories up
-            for (size_t j = i; j < filter->blocked_count - 1; j++) {
-                filter->blocked_categories[j] = filter->blocked_categories[j + 1];
-            }
-            
-            filter->blocked_count--;
-            return true;
-        }
-    }
+    int i = find_blocked_name(filter, category);
+    if (i < 0) return false;
     
-    return false;
+    // Order does not matter; move the last name into the gap
+    free(filter->blocked_categories[i]);
+    filter->blocked_categories[i] = filter->blocked_categories[--filter->blocked_count];
+    return true;
 }
 
 bool category_filter_is_blocked(const CategoryFilter* filter, const char* category) {
     if (!filter || !filter->filter_active || !category) return false;
     
-    for (size_t i = 0; i < filter->blocked_count; i++) {
-        if (strcmp(filter->blocked_categories[i], category) == 0) {
-            return true;
-        }
+    return find_blocked_name(filter, category) >= 0;
+}
+
+bool category_filter_resolve(CategoryFilter* filter, const UI* ui) {
+    if (!filter) return false;
+    
+    if (!item_bitmap_resize(&filter->blocked_ids, (size_t)ui->category_count)) {
+        return false;
     }
+    item_bitmap_clear_all(&filter->blocked_ids);
     
-    return false;
+    // Names are kept because ids change whenever the playlist is reloaded
+    for (size_t i = 0; i < filter->blocked_count; i++) {
+        int id = ui_find_category(ui, filter->blocked_categories[i]);
+        if (id >= 0) item_bitmap_set(&filter->blocked_ids, (uint32_t)id);
+    }
+    return true;
 }
 
 void category_filter_clear(CategoryFilter* filter) {
@@ -87,16 +100,33 @@ void category_filter_clear(CategoryFilter* filter) {
         free(filter->blocked_categories[i]);
     }
     filter->blocked_count = 0;
+    item_bitmap_clear_all(&filter->blocked_ids);
 }
 
-void category_filter_enable(CategoryFilter* filter) {
-    if (filter) filter->filter_active = true;
+void category_filter_enable(CategoryFilter* filter, UI* ui) {
+    if (!filter) return;
+    
+    // The engine keeps the blocked items either way; only visibility follows
+    filter->filter_active = true;
+    if (ui && ui->filter_engine) filter_engine_set_hide_blocked(ui->filter_engine, true);
 }
 
-void category_filter_disable(CategoryFilter* filter) {
-    if (filter) filter->filter_active = false;
+void category_filter_disable(CategoryFilter* filter, UI* ui) {
+    if (!filter) return;
+    
+    filter->filter_active = false;
+    if (ui && ui->filter_engine) filter_engine_set_hide_blocked(ui->filter_engine, false);
 }
 
 bool category_filter_is_enabled(const CategoryFilter* filter) {
     return filter ? filter->filter_active : false;
-} 
\ No newline at end of file
+}
+
+static int find_blocked_name(const CategoryFilter* filter, const char* category) {
+    for (size_t i = 0; i < filter->blocked_count; i++) {
+        if (strcmp(filter->blocked_categories[i], category) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,157 @@
+#include "switch.h"
+#include <string.h>
+
+static void* thread_trampoline(void* arg);
+static void sha256_block(Sha256Context* ctx, const u8* block);
+
+static const u32 sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+Result threadCreate(Thread* t, ThreadFunc entry, void* arg, void* stack_mem, size_t stack_sz,
+                    int prio, int cpuid) {
+    (void)stack_mem;
+    (void)stack_sz;
+    (void)prio;
+    (void)cpuid;
+
+    t->entry = entry;
+    t->arg = arg;
+    t->started = false;
+    return 0;
+}
+
+Result threadStart(Thread* t) {
+    if (pthread_create(&t->handle, NULL, thread_trampoline, t) != 0) return 1;
+    t->started = true;
+    return 0;
+}
+
+Result threadWaitForExit(Thread* t) {
+    if (!t->started) return 0;
+    if (pthread_join(t->handle, NULL) != 0) return 1;
+    t->started = false;
+    return 0;
+}
+
+Result threadClose(Thread* t) {
+    // Like libnx, closing does not wait; a thread never waited on is detached
+    if (t->started) pthread_detach(t->handle);
+    t->started = false;
+    return 0;
+}
+
+void threadExit(void) {
+    pthread_exit(NULL);
+}
+
+void sha256ContextCreate(Sha256Context* ctx) {
+    static const u32 initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(ctx->state, initial, sizeof(initial));
+    ctx->block_length = 0;
+    ctx->total = 0;
+}
+
+void sha256ContextUpdate(Sha256Context* ctx, const void* src, size_t size) {
+    const u8* data = src;
+    ctx->total += size;
+
+    while (size > 0) {
+        size_t chunk = sizeof(ctx->block) - ctx->block_length;
+        if (chunk > size) chunk = size;
+
+        memcpy(ctx->block + ctx->block_length, data, chunk);
+        ctx->block_length += chunk;
+        data += chunk;
+        size -= chunk;
+
+        if (ctx->block_length == sizeof(ctx->block)) {
+            sha256_block(ctx, ctx->block);
+            ctx->block_length = 0;
+        }
+    }
+}
+
+void sha256ContextGetHash(Sha256Context* ctx, void* dst) {
+    u64 bits = ctx->total * 8;
+    u8 padding[72] = {0x80};
+    size_t length = (ctx->block_length < 56 ? 56 : 120) - ctx->block_length;
+    for (int i = 0; i < 8; i++) {
+        padding[length + i] = (u8)(bits >> (56 - 8 * i));
+    }
+    sha256ContextUpdate(ctx, padding, length + 8);
+
+    u8* out = dst;
+    for (int i = 0; i < 8; i++) {
+        out[i * 4] = (u8)(ctx->state[i] >> 24);
+        out[i * 4 + 1] = (u8)(ctx->state[i] >> 16);
+        out[i * 4 + 2] = (u8)(ctx->state[i] >> 8);
+        out[i * 4 + 3] = (u8)ctx->state[i];
+    }
+}
+
+void sha256CalculateHash(void* dst, const void* src, size_t size) {
+    Sha256Context ctx;
+    sha256ContextCreate(&ctx);
+    sha256ContextUpdate(&ctx, src, size);
+    sha256ContextGetHash(&ctx, dst);
+}
+
+static void* thread_trampoline(void* arg) {
+    Thread* t = arg;
+    t->entry(t->arg);
+    return NULL;
+}
+
+static inline u32 rotate_right(u32 value, int bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+static void sha256_block(Sha256Context* ctx, const u8* block) {
+    u32 w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (u32)block[i * 4] << 24 | (u32)block[i * 4 + 1] << 16 |
+               (u32)block[i * 4 + 2] << 8 | block[i * 4 + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        u32 s0 = rotate_right(w[i - 15], 7) ^ rotate_right(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        u32 s1 = rotate_right(w[i - 2], 17) ^ rotate_right(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    u32 a = ctx->state[0], b = ctx->state[1], c = ctx->state[2], d = ctx->state[3];
+    u32 e = ctx->state[4], f = ctx->state[5], g = ctx->state[6], h = ctx->state[7];
+    for (int i = 0; i < 64; i++) {
+        u32 t1 = h + (rotate_right(e, 6) ^ rotate_right(e, 11) ^ rotate_right(e, 25)) +
+                 ((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+        u32 t2 = (rotate_right(a, 2) ^ rotate_right(a, 13) ^ rotate_right(a, 22)) +
+                 ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    ctx->state[0] += a;
+    ctx->state[1] += b;
+    ctx->state[2] += c;
+    ctx->state[3] += d;
+    ctx->state[4] += e;
+    ctx->state[5] += f;
+    ctx->state[6] += g;
+    ctx->state[7] += h;
+}
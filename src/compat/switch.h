@@ -0,0 +1,114 @@
+#ifndef COMPAT_SWITCH_H
+#define COMPAT_SWITCH_H
+
+// Host stand-in for the parts of libnx the app uses, so the UI can be
+// built and benchmarked on Linux. Only on the include path of host builds.
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef u32 Result;
+
+#define R_SUCCEEDED(rc) ((rc) == 0)
+#define R_FAILED(rc) ((rc) != 0)
+
+// Console
+static inline void* consoleInit(void* console) { return console; }
+static inline void consoleExit(void* console) { (void)console; }
+
+// Mutexes
+typedef pthread_mutex_t Mutex;
+
+static inline void mutexInit(Mutex* m) { pthread_mutex_init(m, NULL); }
+static inline void mutexLock(Mutex* m) { pthread_mutex_lock(m); }
+static inline void mutexUnlock(Mutex* m) { pthread_mutex_unlock(m); }
+static inline bool mutexTryLock(Mutex* m) { return pthread_mutex_trylock(m) == 0; }
+
+// Threads; stack, priority and core are left to the host
+typedef void (*ThreadFunc)(void* arg);
+
+typedef struct {
+    pthread_t handle;
+    ThreadFunc entry;
+    void* arg;
+    bool started;
+} Thread;
+
+Result threadCreate(Thread* t, ThreadFunc entry, void* arg, void* stack_mem, size_t stack_sz,
+                    int prio, int cpuid);
+Result threadStart(Thread* t);
+Result threadWaitForExit(Thread* t);
+Result threadClose(Thread* t);
+void threadExit(void);
+
+static inline void svcSleepThread(s64 nano) {
+    struct timespec delay = {(time_t)(nano / 1000000000LL), (long)(nano % 1000000000LL)};
+    nanosleep(&delay, NULL);
+}
+
+// Network services; the host is assumed to be online
+typedef enum { NifmServiceType_User = 1 } NifmServiceType;
+typedef enum { NifmInternetConnectionType_Ethernet = 2 } NifmInternetConnectionType;
+typedef enum {
+    NifmInternetConnectionStatus_ConnectingUnknown1 = 0,
+    NifmInternetConnectionStatus_Connected = 4
+} NifmInternetConnectionStatus;
+
+static inline Result nifmInitialize(NifmServiceType type) { (void)type; return 0; }
+static inline void nifmExit(void) {}
+static inline Result nifmGetInternetConnectionStatus(NifmInternetConnectionType* type,
+                                                     u32* wifi_strength,
+                                                     NifmInternetConnectionStatus* status) {
+    if (type) *type = NifmInternetConnectionType_Ethernet;
+    if (wifi_strength) *wifi_strength = 3;
+    if (status) *status = NifmInternetConnectionStatus_Connected;
+    return 0;
+}
+
+static inline Result socketInitializeDefault(void) { return 0; }
+static inline void socketExit(void) {}
+
+// Shared system fonts; the host has none, so only --benchmark runs there
+typedef enum { PlServiceType_User = 0 } PlServiceType;
+typedef enum { PlSharedFontType_Standard = 0 } PlSharedFontType;
+
+typedef struct {
+    u32 type;
+    u32 offset;
+    u32 size;
+    void* address;
+} PlFontData;
+
+static inline Result plInitialize(PlServiceType type) { (void)type; return 0; }
+static inline void plExit(void) {}
+static inline Result plGetSharedFontByType(PlFontData* font, PlSharedFontType type) {
+    (void)font;
+    (void)type;
+    return 1;
+}
+
+// SHA-256
+#define SHA256_HASH_SIZE 0x20
+
+typedef struct {
+    u32 state[8];
+    u8 block[64];
+    size_t block_length;
+    u64 total;
+} Sha256Context;
+
+void sha256ContextCreate(Sha256Context* ctx);
+void sha256ContextUpdate(Sha256Context* ctx, const void* src, size_t size);
+void sha256ContextGetHash(Sha256Context* ctx, void* dst);
+void sha256CalculateHash(void* dst, const void* src, size_t size);
+
+#endif // COMPAT_SWITCH_H
@@ -66,6 +66,40 @@ bool epg_program_list_add(EPGProgramList* list, const EPGProgram* program) {
     return true;
 }
 
+EPGProgram* epg_program_list_find(const EPGProgramList* list, time_t time) {
+    if (!list || list->program_count == 0) return NULL;
+    
+    // Programs are sorted by start time: find the last one starting by time
+    size_t low = 0;
+    size_t high = list->program_count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (list->programs[mid].start_time <= time) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low == 0) return NULL;
+    
+    EPGProgram* program = &list->programs[low - 1];
+    return time < program->end_time ? program : NULL;
+}
+
+EPGProgram* epg_get_program_at(const EPGData* epg, const char* channel_id, time_t time) {
+    if (!epg || !channel_id) return NULL;
+    
+    // Each list holds the programs of one channel
+    for (size_t i = 0; i < epg->channel_count; i++) {
+        const EPGProgramList* list = &epg->channels[i];
+        if (list->program_count > 0 && list->programs[0].channel_id &&
+            strcmp(list->programs[0].channel_id, channel_id) == 0) {
+            return epg_program_list_find(list, time);
+        }
+    }
+    return NULL;
+}
+
 EPGProgram* epg_program_create(void) {
     EPGProgram* program = malloc(sizeof(EPGProgram));
     if (!program) return NULL;
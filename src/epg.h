@@ -33,6 +33,7 @@ void epg_free(EPGData* epg);
 bool epg_load_xmltv(EPGData* epg, const char* filename);
 bool epg_save_cache(const EPGData* epg, const char* filename);
 bool epg_load_cache(EPGData* epg, const char* filename);
+EPGProgram* epg_get_program_at(const EPGData* epg, const char* channel_id, time_t time);
 
 // Program list functions
 EPGProgramList* epg_program_list_create(void);
@@ -0,0 +1,383 @@
+#include "filter_engine.h"
+#include "ui.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void build_category_mask(FilterEngine* engine);
+static bool category_view_applies(const FilterEngine* engine);
+static void mark_dirty(FilterEngine* engine);
+static void update_item_visibility(FilterEngine* engine, uint32_t item);
+
+FilterEngine* filter_engine_create(void) {
+    FilterEngine* engine = calloc(1, sizeof(FilterEngine));
+    if (!engine) return NULL;
+
+    engine->selected_category = FILTER_NO_CATEGORY;
+    engine->hide_blocked = true;
+    engine->age_limit = FILTER_NO_AGE_LIMIT;
+    result_set_init(&engine->visible_items);
+
+    return engine;
+}
+
+void filter_engine_free(FilterEngine* engine) {
+    if (!engine) return;
+
+    item_bitmap_free(&engine->favorites);
+    item_bitmap_free(&engine->blocked);
+    item_bitmap_free(&engine->restricted);
+    item_bitmap_free(&engine->category);
+    item_bitmap_free(&engine->visible);
+    result_set_free(&engine->visible_items);
+    free(engine);
+}
+
+bool filter_engine_rebuild(FilterEngine* engine, const Playlist* playlist,
+                           const CategoryIndex* index, int category_count,
+                           const struct CategoryFilter* blocked, int age_limit) {
+    size_t count = playlist ? playlist->count : 0;
+
+    if (!item_bitmap_resize(&engine->favorites, count) ||
+        !item_bitmap_resize(&engine->blocked, count) ||
+        !item_bitmap_resize(&engine->restricted, count) ||
+        !item_bitmap_resize(&engine->category, count) ||
+        !item_bitmap_resize(&engine->visible, count)) {
+        return false;
+    }
+
+    item_bitmap_clear_all(&engine->favorites);
+    item_bitmap_clear_all(&engine->blocked);
+    item_bitmap_clear_all(&engine->restricted);
+
+    engine->item_count = count;
+    engine->categories = index;
+    engine->blocked_filter = blocked;
+    engine->category_count = category_count;
+    engine->age_limit = age_limit;
+    engine->hide_blocked = category_filter_is_enabled(blocked);
+    engine->restricted_count = 0;
+
+    // Blocked state is per category; only blocked categories' item lists
+    // are touched
+    for (int c = 0; c < category_count; c++) {
+        if (!category_filter_has_id(blocked, (uint32_t)c) || !index || !index->items) {
+            continue;
+        }
+
+        for (uint32_t i = index->offsets[c]; i < index->offsets[c + 1]; i++) {
+            item_bitmap_set(&engine->blocked, index->items[i]);
+        }
+    }
+
+    // Single pass over the playlist fills the per-item predicates
+    for (size_t i = 0; i < count; i++) {
+        const PlaylistItem* item = &playlist->items[i];
+
+        if (item->favorite) {
+            item_bitmap_set(&engine->favorites, (uint32_t)i);
+        }
+        if (age_limit != FILTER_NO_AGE_LIMIT && item->age_rating > age_limit) {
+            item_bitmap_set(&engine->restricted, (uint32_t)i);
+            engine->restricted_count++;
+        }
+    }
+
+    if (engine->selected_category != FILTER_NO_CATEGORY &&
+        engine->selected_category >= (uint32_t)category_count) {
+        engine->selected_category = FILTER_NO_CATEGORY;
+    }
+    engine->category_dirty = true;
+    mark_dirty(engine);
+
+    return true;
+}
+
+void filter_engine_evaluate(FilterEngine* engine) {
+    size_t words = ITEM_BITMAP_WORDS(engine->item_count);
+    bool by_category = engine->selected_category != FILTER_NO_CATEGORY;
+
+    if (by_category && engine->category_dirty) {
+        build_category_mask(engine);
+    }
+
+    const uint64_t* category = engine->category.words;
+    const uint64_t* favorites = engine->favorites.words;
+    const uint64_t* blocked = engine->blocked.words;
+    const uint64_t* restricted = engine->restricted.words;
+    uint64_t* visible = engine->visible.words;
+
+    // All predicates combined word by word in a single pass
+    for (size_t w = 0; w < words; w++) {
+        uint64_t bits = by_category ? category[w] : ~(uint64_t)0;
+        if (engine->favorites_only) bits &= favorites[w];
+        if (engine->hide_blocked) bits &= ~blocked[w];
+        bits &= ~restricted[w];
+        visible[w] = bits;
+    }
+
+    if (engine->item_count & 63) {
+        visible[words - 1] &= ((uint64_t)1 << (engine->item_count & 63)) - 1;
+    }
+
+    engine->visible_dirty = false;
+    engine->visible_items_dirty = true;
+}
+
+void filter_engine_set_category(FilterEngine* engine, uint32_t category) {
+    if (category != FILTER_NO_CATEGORY && category >= (uint32_t)engine->category_count) {
+        category = FILTER_NO_CATEGORY;
+    }
+    if (engine->selected_category == category) return;
+
+    // The mask is only built if a later filter needs the bitmap path
+    engine->selected_category = category;
+    engine->category_dirty = true;
+    mark_dirty(engine);
+}
+
+void filter_engine_set_favorites_only(FilterEngine* engine, bool enabled) {
+    if (engine->favorites_only == enabled) return;
+
+    engine->favorites_only = enabled;
+    mark_dirty(engine);
+}
+
+void filter_engine_set_hide_blocked(FilterEngine* engine, bool enabled) {
+    if (engine->hide_blocked == enabled) return;
+
+    engine->hide_blocked = enabled;
+    mark_dirty(engine);
+}
+
+void filter_engine_set_age_limit(FilterEngine* engine, const Playlist* playlist, int age_limit) {
+    if (engine->age_limit == age_limit) return;
+
+    engine->age_limit = age_limit;
+    engine->restricted_count = 0;
+    item_bitmap_clear_all(&engine->restricted);
+
+    if (age_limit != FILTER_NO_AGE_LIMIT && playlist) {
+        for (size_t i = 0; i < engine->item_count && i < playlist->count; i++) {
+            if (playlist->items[i].age_rating > age_limit) {
+                item_bitmap_set(&engine->restricted, (uint32_t)i);
+                engine->restricted_count++;
+            }
+        }
+    }
+
+    mark_dirty(engine);
+}
+
+void filter_engine_set_favorite(FilterEngine* engine, uint32_t item, bool favorite) {
+    if (item >= engine->item_count) return;
+
+    if (favorite) {
+        item_bitmap_set(&engine->favorites, item);
+    } else {
+        item_bitmap_reset(&engine->favorites, item);
+    }
+
+    // Only this item's visibility can change
+    update_item_visibility(engine, item);
+}
+
+void filter_engine_set_category_blocked(FilterEngine* engine, uint32_t category, bool blocked) {
+    const CategoryIndex* index = engine->categories;
+    if (category >= (uint32_t)engine->category_count || !index || !index->items) return;
+
+    // Only the items of this category are touched
+    for (uint32_t i = index->offsets[category]; i < index->offsets[category + 1]; i++) {
+        uint32_t item = index->items[i];
+        if (blocked) {
+            item_bitmap_set(&engine->blocked, item);
+        } else {
+            item_bitmap_reset(&engine->blocked, item);
+        }
+        update_item_visibility(engine, item);
+    }
+
+    // The category view reads the blocked state directly
+    if (category == engine->selected_category) {
+        engine->visible_items_dirty = true;
+    }
+}
+
+size_t filter_engine_visible(FilterEngine* engine, const uint32_t** indices) {
+    // Category alone: the view is the category's item list as is
+    if (category_view_applies(engine)) {
+        const CategoryIndex* index = engine->categories;
+        uint32_t category = engine->selected_category;
+        *indices = &index->items[index->offsets[category]];
+        return index->offsets[category + 1] - index->offsets[category];
+    }
+
+    const ItemBitmap* visible = filter_engine_visible_bitmap(engine);
+    if (engine->visible_items_dirty) {
+        result_set_from_bitmap(&engine->visible_items, visible);
+        engine->visible_items_dirty = false;
+    }
+
+    *indices = engine->visible_items.indices;
+    return engine->visible_items.count;
+}
+
+const ItemBitmap* filter_engine_visible_bitmap(FilterEngine* engine) {
+    if (engine->visible_dirty) {
+        filter_engine_evaluate(engine);
+    }
+    return &engine->visible;
+}
+
+bool filter_engine_combine(const FilterEngine* engine, uint32_t category,
+                           bool favorites_only, ItemBitmap* out) {
+    if (!item_bitmap_resize(out, engine->item_count)) return false;
+
+    // Same predicates as the view, into the caller's bitmap; the engine's
+    // own selection is left alone
+    const CategoryIndex* index = engine->categories;
+    if (category != FILTER_NO_CATEGORY && category < (uint32_t)engine->category_count &&
+        index && index->items) {
+        item_bitmap_clear_all(out);
+        for (uint32_t i = index->offsets[category]; i < index->offsets[category + 1]; i++) {
+            item_bitmap_set(out, index->items[i]);
+        }
+    } else {
+        item_bitmap_set_all(out);
+    }
+
+    if (favorites_only) item_bitmap_and(out, &engine->favorites);
+    if (engine->hide_blocked) item_bitmap_andnot(out, &engine->blocked);
+    item_bitmap_andnot(out, &engine->restricted);
+    return true;
+}
+
+bool filter_engine_is_visible(FilterEngine* engine, uint32_t item) {
+    return item < engine->item_count &&
+           item_bitmap_test(filter_engine_visible_bitmap(engine), item);
+}
+
+void ui_rebuild_filters(UI* ui) {
+    if (!ui) return;
+
+    if (!ui->filter_engine) {
+        ui->filter_engine = filter_engine_create();
+        if (!ui->filter_engine) return;
+    }
+
+    // Blocked names map to new ids whenever the category list changes
+    category_filter_resolve(ui->category_filter, ui);
+
+    filter_engine_rebuild(ui->filter_engine, ui->playlist, &ui->category_index,
+                          ui->category_count, ui->category_filter,
+                          ui->filter_engine->age_limit);
+}
+
+void ui_select_category(UI* ui, int category) {
+    if (!ui || !ui->filter_engine) return;
+
+    filter_engine_set_category(ui->filter_engine,
+                               category < 0 ? FILTER_NO_CATEGORY : (uint32_t)category);
+
+    // Positions in the old view mean nothing in the new one
+    ui->selected_item = 0;
+    ui->scroll_offset = 0;
+    ui_invalidate(ui, UI_DIRTY_CONTENT);
+}
+
+void ui_set_favorites_only(UI* ui, bool enabled) {
+    if (!ui || !ui->filter_engine) return;
+
+    filter_engine_set_favorites_only(ui->filter_engine, enabled);
+    ui->selected_item = 0;
+    ui->scroll_offset = 0;
+    ui_invalidate(ui, UI_DIRTY_CONTENT);
+}
+
+void ui_set_favorite(UI* ui, PlaylistItem* item, bool favorite) {
+    if (!ui || !ui->playlist || !item) return;
+
+    size_t index = (size_t)(item - ui->playlist->items);
+    playlist_set_favorite(ui->playlist, index, favorite);
+    if (ui->filter_engine && ui->filter_engine->item_count == ui->playlist->count) {
+        filter_engine_set_favorite(ui->filter_engine, (uint32_t)index, favorite);
+    }
+
+    // Unmarking an item under favorites only can shrink the view below the selection
+    int count = (int)ui_visible_count(ui);
+    if (ui->selected_item >= count) ui->selected_item = MAX(count - 1, 0);
+    ui_invalidate(ui, UI_DIRTY_CONTENT);
+}
+
+size_t ui_visible_count(UI* ui) {
+    if (!ui->playlist) return 0;
+    if (!ui->filter_engine || ui->filter_engine->item_count != ui->playlist->count) {
+        return ui->playlist->count;
+    }
+    const uint32_t* indices;
+    return filter_engine_visible(ui->filter_engine, &indices);
+}
+
+PlaylistItem* ui_visible_item(UI* ui, size_t position) {
+    if (!ui->playlist) return NULL;
+
+    // Without an up-to-date engine every item is shown
+    if (!ui->filter_engine || ui->filter_engine->item_count != ui->playlist->count) {
+        return position < ui->playlist->count ? &ui->playlist->items[position] : NULL;
+    }
+
+    const uint32_t* indices;
+    size_t count = filter_engine_visible(ui->filter_engine, &indices);
+    if (position >= count) return NULL;
+    return &ui->playlist->items[indices[position]];
+}
+
+static void build_category_mask(FilterEngine* engine) {
+    item_bitmap_clear_all(&engine->category);
+    engine->category_dirty = false;
+
+    const CategoryIndex* index = engine->categories;
+    uint32_t category = engine->selected_category;
+    if (category == FILTER_NO_CATEGORY || !index || !index->items) return;
+
+    // Only the selected category's items are visited
+    for (uint32_t i = index->offsets[category]; i < index->offsets[category + 1]; i++) {
+        item_bitmap_set(&engine->category, index->items[i]);
+    }
+}
+
+static bool category_view_applies(const FilterEngine* engine) {
+    uint32_t category = engine->selected_category;
+    if (category == FILTER_NO_CATEGORY) return false;
+    if (!engine->categories || !engine->categories->items) return false;
+
+    return !engine->favorites_only && engine->restricted_count == 0 &&
+           !(engine->hide_blocked && category_filter_has_id(engine->blocked_filter, category));
+}
+
+static void update_item_visibility(FilterEngine* engine, uint32_t item) {
+    // A pending evaluation picks the change up anyway
+    if (engine->visible_dirty) return;
+
+    bool visible = !engine->favorites_only || item_bitmap_test(&engine->favorites, item);
+    if (engine->selected_category != FILTER_NO_CATEGORY) {
+        visible = visible && item_bitmap_test(&engine->category, item);
+    }
+    if (engine->hide_blocked) {
+        visible = visible && !item_bitmap_test(&engine->blocked, item);
+    }
+    visible = visible && !item_bitmap_test(&engine->restricted, item);
+
+    if (visible != item_bitmap_test(&engine->visible, item)) {
+        if (visible) {
+            item_bitmap_set(&engine->visible, item);
+        } else {
+            item_bitmap_reset(&engine->visible, item);
+        }
+        engine->visible_items_dirty = true;
+    }
+}
+
+static void mark_dirty(FilterEngine* engine) {
+    engine->visible_dirty = true;
+    engine->visible_items_dirty = true;
+}
@@ -0,0 +1,85 @@
+#ifndef FILTER_ENGINE_H
+#define FILTER_ENGINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "result_set.h"
+#include "playlist.h"
+#include "categories.h"
+
+// Forward declarations
+struct UI;
+typedef struct UI UI;
+struct CategoryFilter;
+
+#define FILTER_NO_CATEGORY UINT32_MAX
+#define FILTER_NO_AGE_LIMIT -1
+
+// Visibility filter engine
+//
+// Every predicate is kept as a bitmap over playlist item indices. The
+// visible set is recomputed in one pass over 64-bit words, so toggling a
+// filter costs item_count / 64 operations instead of a walk over every item.
+// Per-category bitmaps would cost item_count / 8 bytes per group, so the
+// selected category's mask is built on demand from its CategoryIndex list.
+//
+// When only a category is selected and none of its items are filtered out,
+// the view is the category's item list itself and no bitmap work happens.
+typedef struct FilterEngine {
+    size_t item_count;
+
+    // Predicate bitmaps
+    ItemBitmap favorites;
+    ItemBitmap blocked;
+    ItemBitmap restricted;
+    ItemBitmap category;         // Items in selected_category
+    size_t restricted_count;
+
+    // Per-category item lists and blocked ids, owned by the UI
+    const CategoryIndex* categories;
+    const struct CategoryFilter* blocked_filter;
+    int category_count;
+
+    // Active filters
+    uint32_t selected_category;
+    bool favorites_only;
+    bool hide_blocked;
+    int age_limit;               // Items rated above this are restricted
+
+    // Result of the last evaluation, recomputed on first use after a change
+    ItemBitmap visible;
+    ResultSet visible_items;
+    bool visible_dirty;
+    bool visible_items_dirty;
+    bool category_dirty;
+} FilterEngine;
+
+// Filter engine functions
+FilterEngine* filter_engine_create(void);
+void filter_engine_free(FilterEngine* engine);
+bool filter_engine_rebuild(FilterEngine* engine, const Playlist* playlist,
+                           const CategoryIndex* index, int category_count,
+                           const struct CategoryFilter* blocked, int age_limit);
+void filter_engine_evaluate(FilterEngine* engine);
+void filter_engine_set_category(FilterEngine* engine, uint32_t category);
+void filter_engine_set_favorites_only(FilterEngine* engine, bool enabled);
+void filter_engine_set_hide_blocked(FilterEngine* engine, bool enabled);
+void filter_engine_set_age_limit(FilterEngine* engine, const Playlist* playlist, int age_limit);
+void filter_engine_set_favorite(FilterEngine* engine, uint32_t item, bool favorite);
+void filter_engine_set_category_blocked(FilterEngine* engine, uint32_t category, bool blocked);
+size_t filter_engine_visible(FilterEngine* engine, const uint32_t** indices);
+const ItemBitmap* filter_engine_visible_bitmap(FilterEngine* engine);
+bool filter_engine_combine(const FilterEngine* engine, uint32_t category,
+                           bool favorites_only, ItemBitmap* out);
+bool filter_engine_is_visible(FilterEngine* engine, uint32_t item);
+
+// UI integration
+void ui_rebuild_filters(UI* ui);
+void ui_select_category(UI* ui, int category);
+void ui_set_favorites_only(UI* ui, bool enabled);
+void ui_set_favorite(UI* ui, PlaylistItem* item, bool favorite);
+size_t ui_visible_count(UI* ui);
+PlaylistItem* ui_visible_item(UI* ui, size_t position);
+
+#endif // FILTER_ENGINE_H
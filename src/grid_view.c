@@ -1,10 +1,16 @@
 #include "ui.h"
+#include "drawing.h"
+#include "filter_engine.h"
+#include "render_batch.h"
 #include <SDL2/SDL_image.h>
 
 void ui_draw_grid(UI* ui) {
     if (!ui->playlist) return;
     
     SDL_Color white = {255, 255, 255, 255};
+    SDL_Color accent = {0x00, 0xA5, 0xE0, 0xFF};
+    SDL_Color placeholder = {0x40, 0x40, 0x40, 0xFF};
+    SDL_Color shade = {0, 0, 0, 192};
     
     // Calculate grid dimensions
     int item_width = (WINDOW_WIDTH - 60) / ui->grid_columns;
@@ -15,41 +21,40 @@ void ui_draw_grid(UI* ui) {
     int x = 20;
     int y = 80;
     int grid_index = ui->scroll_offset * ui->grid_columns;
+    int item_count = (int)ui_visible_count(ui);
     
-    for (int row = 0; row < ui->grid_rows && grid_index < (int)ui->playlist->count; row++) {
-        for (int col = 0; col < ui->grid_columns && grid_index < (int)ui->playlist->count; col++) {
-            PlaylistItem* item = &ui->playlist->items[grid_index];
+    for (int row = 0; row < ui->grid_rows && grid_index < item_count; row++) {
+        for (int col = 0; col < ui->grid_columns && grid_index < item_count; col++) {
+            PlaylistItem* item = ui_visible_item(ui, grid_index);
             SDL_Rect item_rect = {x + col * (item_width + spacing),
                                 y + row * (item_height + spacing),
                                 item_width, item_height};
             
             // Draw selection highlight
             if (grid_index == ui->selected_item) {
-                SDL_SetRenderDrawColor(ui->renderer, 0x00, 0xA5, 0xE0, 0xFF);
                 SDL_Rect highlight = {item_rect.x - 2, item_rect.y - 2,
                                     item_rect.w + 4, item_rect.h + 4};
-                SDL_RenderFillRect(ui->renderer, &highlight);
+                render_batch_rect(ui->renderer, RENDER_LAYER_BACKGROUND, &highlight, accent);
             }
             
             // Draw thumbnail or placeholder
             SDL_Texture* thumb = NULL;
+            SDL_Rect thumb_src;
             if (item->tvg_logo) {
-                thumb = ui_get_thumbnail(ui, item->tvg_logo);
+                thumb = ui_get_thumbnail(ui, item->tvg_logo, &thumb_src);
             }
             
             if (thumb) {
-                SDL_RenderCopy(ui->renderer, thumb, NULL, &item_rect);
+                render_batch_texture(ui->renderer, RENDER_LAYER_CONTENT, thumb, &thumb_src, &item_rect);
             } else {
                 // Draw placeholder
-                SDL_SetRenderDrawColor(ui->renderer, 0x40, 0x40, 0x40, 0xFF);
-                SDL_RenderFillRect(ui->renderer, &item_rect);
+                render_batch_rect(ui->renderer, RENDER_LAYER_CONTENT, &item_rect, placeholder);
             }
             
             // Draw title
             SDL_Rect title_bg = {item_rect.x, item_rect.y + item_rect.h - 30,
                                 item_rect.w, 30};
-            SDL_SetRenderDrawColor(ui->renderer, 0, 0, 0, 192);
-            SDL_RenderFillRect(ui->renderer, &title_bg);
+            render_batch_rect(ui->renderer, RENDER_LAYER_OVERLAY, &title_bg, shade);
             
             draw_text(ui->renderer, ui->font, item->title,
                      item_rect.x + 5, title_bg.y + 5, white, false);
@@ -58,6 +63,10 @@ void ui_draw_grid(UI* ui) {
         }
     }
     
+    // Queue the rows the view is scrolling towards
+    ui_prefetch_thumbnails(ui, ui->scroll_offset * ui->grid_columns,
+                           ui->grid_rows * ui->grid_columns);
+    
     // Draw controls
     draw_text(ui->renderer, ui->font,
               "A: Select   B: Back   Y: View Mode   X: Search",
@@ -68,6 +77,9 @@ void ui_draw_epg_grid(UI* ui) {
     if (!ui->epg) return;
     
     SDL_Color white = {255, 255, 255, 255};
+    SDL_Color channel_color = {0x40, 0x40, 0x40, 0xFF};
+    SDL_Color current_color = {0x00, 0xA5, 0xE0, 0xFF};
+    SDL_Color program_color = {0x30, 0x30, 0x30, 0xFF};
     
     // Calculate time slots
     time_t now = time(NULL);
@@ -90,23 +102,26 @@ void ui_draw_epg_grid(UI* ui) {
     int y = 80;
     int row = 0;
     
-    for (size_t i = ui->scroll_offset;
-         i < ui->playlist->count && y < WINDOW_HEIGHT - 60;
+    size_t item_count = ui_visible_count(ui);
+    size_t i;
+    
+    for (i = ui->scroll_offset;
+         i < item_count && y < WINDOW_HEIGHT - 60;
          i++) {
-        PlaylistItem* item = &ui->playlist->items[i];
+        PlaylistItem* item = ui_visible_item(ui, i);
         if (!item->tvg_id) continue;
         
         // Draw channel info
         SDL_Rect channel_rect = {0, y, 190, 50};
-        SDL_SetRenderDrawColor(ui->renderer, 0x40, 0x40, 0x40, 0xFF);
-        SDL_RenderFillRect(ui->renderer, &channel_rect);
+        render_batch_rect(ui->renderer, RENDER_LAYER_BACKGROUND, &channel_rect, channel_color);
         
         // Draw channel logo
         if (item->tvg_logo) {
-            SDL_Texture* logo = ui_get_thumbnail(ui, item->tvg_logo);
+            SDL_Rect logo_src;
+            SDL_Texture* logo = ui_get_thumbnail(ui, item->tvg_logo, &logo_src);
             if (logo) {
                 SDL_Rect logo_rect = {5, y + 5, 40, 40};
-                SDL_RenderCopy(ui->renderer, logo, NULL, &logo_rect);
+                render_batch_texture(ui->renderer, RENDER_LAYER_CONTENT, logo, &logo_src, &logo_rect);
             }
         }
         
@@ -127,12 +142,9 @@ void ui_draw_epg_grid(UI* ui) {
                 SDL_Rect prog_rect = {prog_x, y, prog_w, 50};
                 
                 // Highlight current program
-                if (now >= prog->start_time && now < prog->end_time) {
-                    SDL_SetRenderDrawColor(ui->renderer, 0x00, 0xA5, 0xE0, 0xFF);
-                } else {
-                    SDL_SetRenderDrawColor(ui->renderer, 0x30, 0x30, 0x30, 0xFF);
-                }
-                SDL_RenderFillRect(ui->renderer, &prog_rect);
+                bool current = now >= prog->start_time && now < prog->end_time;
+                render_batch_rect(ui->renderer, RENDER_LAYER_BACKGROUND, &prog_rect,
+                                  current ? current_color : program_color);
                 
                 // Draw program title
                 draw_text(ui->renderer, ui->font, prog->title,
@@ -143,4 +155,7 @@ void ui_draw_epg_grid(UI* ui) {
         y += 60;
         row++;
     }
+    
+    // Queue the channels the guide is scrolling towards
+    ui_prefetch_thumbnails(ui, ui->scroll_offset, (int)(i - ui->scroll_offset));
 } 
\ No newline at end of file
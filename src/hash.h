@@ -0,0 +1,37 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// FNV-1a hashes for cache and lookup table keys
+
+#define FNV32_OFFSET 2166136261u
+#define FNV32_PRIME 16777619u
+#define FNV64_OFFSET 14695981039346656037ull
+#define FNV64_PRIME 1099511628211ull
+
+static inline uint32_t hash_string32(const char* text) {
+    uint32_t hash = FNV32_OFFSET;
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        hash = (hash ^ *p) * FNV32_PRIME;
+    }
+    return hash;
+}
+
+static inline uint64_t hash_bytes64(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ p[i]) * FNV64_PRIME;
+    }
+    return hash;
+}
+
+static inline uint64_t hash_string64(uint64_t hash, const char* text) {
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        hash = (hash ^ *p) * FNV64_PRIME;
+    }
+    return hash;
+}
+
+#endif // HASH_H
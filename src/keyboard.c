@@ -4,6 +4,7 @@
 #include "ui_constants.h"
 #include <string.h>
 #include <ctype.h>
+#include <stdlib.h>
 
 static const char keyboard_layout[KEYBOARD_ROWS][KEYBOARD_COLS] = {
     "1234567890",
@@ -50,6 +51,9 @@ void keyboard_handle_input(UI* ui, SDL_Event* event) {
 void keyboard_handle_keypress(UI* ui, SDL_Keycode key) {
     size_t len = strlen(ui->keyboard.text);
     
+    // Selection wraps within the suggestions actually shown
+    int count = (int)ui->keyboard.suggestion_count;
+    
     if (key == SDLK_BACKSPACE && len > 0) {
         ui->keyboard.text[len - 1] = '\0';
     }
@@ -61,6 +65,9 @@ void keyboard_handle_keypress(UI* ui, SDL_Keycode key) {
                    ui->keyboard.suggestions[ui->keyboard.selected_suggestion],
                    MAX_INPUT_LENGTH - 1);
         }
+        
+        // A submitted query counts towards its rank in the history
+        search_history_add(ui->keyboard.history, ui->keyboard.text);
         keyboard_hide(ui);
         return;
     }
@@ -70,7 +77,7 @@ void keyboard_handle_keypress(UI* ui, SDL_Keycode key) {
                 ui->keyboard.selected_suggestion = ui->keyboard.suggestion_count - 1;
             } else {
                 ui->keyboard.selected_suggestion = 
-                    (ui->keyboard.selected_suggestion - 1 + KEYBOARD_ROWS) % KEYBOARD_ROWS;
+                    (ui->keyboard.selected_suggestion - 1 + count) % count;
             }
         }
     }
@@ -80,7 +87,7 @@ void keyboard_handle_keypress(UI* ui, SDL_Keycode key) {
                 ui->keyboard.selected_suggestion = 0;
             } else {
                 ui->keyboard.selected_suggestion = 
-                    (ui->keyboard.selected_suggestion + 1) % KEYBOARD_ROWS;
+                    (ui->keyboard.selected_suggestion + 1) % count;
             }
         }
     }
@@ -90,7 +97,7 @@ void keyboard_handle_keypress(UI* ui, SDL_Keycode key) {
                 ui->keyboard.selected_suggestion = 0;
             } else {
                 ui->keyboard.selected_suggestion = 
-                    (ui->keyboard.selected_suggestion + 1) % KEYBOARD_COLS;
+                    (ui->keyboard.selected_suggestion + 1) % count;
             }
         }
     }
@@ -101,6 +108,11 @@ void keyboard_handle_keypress(UI* ui, SDL_Keycode key) {
     
     // Update suggestions
     search_history_update_suggestions(ui);
+    
+    // Search as you type; a newer keystroke cancels the previous query
+    if (ui->state == UI_STATE_SEARCH) {
+        ui_perform_search(ui);
+    }
 }
 
 void keyboard_handle_click(UI* ui, int x, int y) {
@@ -0,0 +1,64 @@
+#include "list_view.h"
+#include "ui.h"
+#include "drawing.h"
+#include "text_renderer.h"
+
+void list_view_layout(ListView* view, int x, int y, int w, int h, int row_height) {
+    view->bounds.x = x;
+    view->bounds.y = y;
+    view->bounds.w = w;
+    view->bounds.h = h;
+    view->row_height = row_height > 0 ? row_height : ITEM_HEIGHT;
+}
+
+int list_view_visible_rows(const ListView* view) {
+    int rows = view->row_height > 0 ? view->bounds.h / view->row_height : 0;
+    return rows > 0 ? rows : 1;
+}
+
+void list_view_visible_range(const ListView* view, int count, int* first, int* end) {
+    *first = MAX(0, MIN(view->scroll, count));
+    *end = MIN(count, *first + list_view_visible_rows(view));
+}
+
+void list_view_follow(ListView* view, int selected, int count) {
+    int rows = list_view_visible_rows(view);
+
+    // Keep the selection on screen with as little movement as possible
+    if (selected >= 0 && selected < view->scroll) {
+        view->scroll = selected;
+    } else if (selected >= view->scroll + rows) {
+        view->scroll = selected - rows + 1;
+    }
+
+    view->scroll = MAX(0, MIN(view->scroll, count - rows));
+}
+
+void list_view_draw(ListView* view, UI* ui, int count, int selected, ListViewLabelFunc label) {
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Color highlight = {255, 255, 0, 255};
+    char buffer[LIST_VIEW_LABEL_LENGTH];
+
+    int first, end;
+    list_view_visible_range(view, count, &first, &end);
+
+    for (int i = first; i < end; i++) {
+        const char* text = label(ui, i, buffer, sizeof(buffer));
+        if (!text) continue;
+
+        int y = view->bounds.y + (i - first) * view->row_height;
+        draw_text(ui->renderer, ui->font, text, view->bounds.x, y,
+                  i == selected ? highlight : white, false);
+    }
+
+    // Overscan: load the glyphs of the rows next to the viewport
+    int before = MAX(0, first - LIST_VIEW_OVERSCAN);
+    int after = MIN(count, end + LIST_VIEW_OVERSCAN);
+    for (int i = before; i < after; i++) {
+        if (i == first) i = end;
+        if (i >= after) break;
+
+        const char* text = label(ui, i, buffer, sizeof(buffer));
+        if (text) text_renderer_measure(ui->renderer, ui->font, text);
+    }
+}
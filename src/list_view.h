@@ -0,0 +1,37 @@
+#ifndef LIST_VIEW_H
+#define LIST_VIEW_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Forward declarations
+struct UI;
+typedef struct UI UI;
+
+#define LIST_VIEW_OVERSCAN 2
+#define LIST_VIEW_LABEL_LENGTH 256
+
+// Returns the label for row index; may format into buffer or return a
+// string owned by the caller
+typedef const char* (*ListViewLabelFunc)(UI* ui, int index, char* buffer, size_t size);
+
+// Virtualized list of text rows
+//
+// Only rows inside bounds are visited, so drawing costs the same for 50 or
+// 50,000 entries. Rows just outside the viewport are laid out without being
+// drawn so their glyphs are already in the text atlas when they scroll in.
+typedef struct {
+    SDL_Rect bounds;
+    int row_height;
+    int scroll;          // First visible row
+} ListView;
+
+// List view functions
+void list_view_layout(ListView* view, int x, int y, int w, int h, int row_height);
+int list_view_visible_rows(const ListView* view);
+void list_view_visible_range(const ListView* view, int count, int* first, int* end);
+void list_view_follow(ListView* view, int selected, int count);
+void list_view_draw(ListView* view, UI* ui, int count, int selected, ListViewLabelFunc label);
+
+#endif // LIST_VIEW_H
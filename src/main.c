@@ -1,8 +1,21 @@
 #include <switch.h>
+#include <string.h>
 #include "ui.h"
+#ifdef UI_BENCHMARK
+#include "benchmark.h"
+#endif
 
 int main(int argc, char* argv[])
 {
+#ifdef UI_BENCHMARK
+    // --benchmark [font] [output]: scripted headless run, then exit
+    if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+        bool ok = benchmark_run(argc > 2 ? argv[2] : BENCHMARK_FONT,
+                                argc > 3 ? argv[3] : BENCHMARK_OUTPUT);
+        return ok ? 0 : 1;
+    }
+#endif
+    
     // Initialize console
     consoleInit(NULL);
     
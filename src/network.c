@@ -5,6 +5,7 @@
 #include <sys/select.h>
 #include <errno.h>
 #include <string.h>
+#include <strings.h>
 #include <stdlib.h>
 
 static char last_error[256] = {0};
@@ -62,6 +63,54 @@ static size_t write_callback(void* contents, size_t size, size_t nmemb, void* us
     return realsize;
 }
 
+// Collects ETag and Last-Modified from the response headers
+static size_t header_callback(char* buffer, size_t size, size_t nitems, void* userp) {
+    size_t length = size * nitems;
+    NetworkValidators* validators = (NetworkValidators*)userp;
+
+    // Each redirect hop starts a new response; only the last one's
+    // validators describe the body
+    if (length > 5 && strncmp(buffer, "HTTP/", 5) == 0) {
+        memset(validators, 0, sizeof(NetworkValidators));
+        return length;
+    }
+
+    char* field = NULL;
+    size_t field_size = 0;
+    size_t name_length = 0;
+    if (length > 5 && strncasecmp(buffer, "ETag:", 5) == 0) {
+        field = validators->etag;
+        field_size = sizeof(validators->etag);
+        name_length = 5;
+    } else if (length > 14 && strncasecmp(buffer, "Last-Modified:", 14) == 0) {
+        field = validators->last_modified;
+        field_size = sizeof(validators->last_modified);
+        name_length = 14;
+    }
+
+    if (field) {
+        const char* value = buffer + name_length;
+        size_t value_length = length - name_length;
+        while (value_length > 0 && (*value == ' ' || *value == '\t')) {
+            value++;
+            value_length--;
+        }
+        while (value_length > 0 && (value[value_length - 1] == '\r' ||
+                                    value[value_length - 1] == '\n' ||
+                                    value[value_length - 1] == ' ')) {
+            value_length--;
+        }
+
+        // A value that does not fit is useless for revalidation; drop it
+        if (value_length < field_size) {
+            memcpy(field, value, value_length);
+            field[value_length] = '\0';
+        }
+    }
+
+    return length;
+}
+
 bool network_init(void) {
     // Initialize network services
     Result rc = socketInitializeDefault();
@@ -142,6 +191,66 @@ NetworkBuffer* network_download(const char* url) {
     return buffer;
 }
 
+long network_download_revalidate(const char* url, NetworkValidators* validators,
+                                 NetworkBuffer** body) {
+    *body = NULL;
+
+    NetworkBuffer* buffer = (NetworkBuffer*)calloc(1, sizeof(NetworkBuffer));
+    CURL* curl = curl_init_switch();
+    if (!buffer || !curl) {
+        free(buffer);
+        if (curl) curl_easy_cleanup(curl);
+        return 0;
+    }
+
+    // Validators from the previous download turn this into a conditional
+    // request; an unchanged resource then comes back as 304 without a body
+    struct curl_slist* headers = NULL;
+    char header[192];
+    if (validators->etag[0]) {
+        snprintf(header, sizeof(header), "If-None-Match: %s", validators->etag);
+        headers = curl_slist_append(headers, header);
+    }
+    if (validators->last_modified[0]) {
+        snprintf(header, sizeof(header), "If-Modified-Since: %s", validators->last_modified);
+        headers = curl_slist_append(headers, header);
+    }
+
+    NetworkValidators fresh = {0};
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, buffer);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &fresh);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+
+    long status = 0;
+    CURLcode res = curl_easy_perform(curl);
+    if (res == CURLE_OK) {
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    }
+
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(curl);
+
+    if (status == 200) {
+        *validators = fresh;
+        *body = buffer;
+        return status;
+    }
+
+    // A 304 may carry updated validators for the same content
+    if (status == 304) {
+        if (fresh.etag[0]) strcpy(validators->etag, fresh.etag);
+        if (fresh.last_modified[0]) strcpy(validators->last_modified, fresh.last_modified);
+    }
+
+    network_buffer_free(buffer);
+    return status;
+}
+
 void network_buffer_free(NetworkBuffer* buffer) {
     if (buffer) {
         free(buffer->data);
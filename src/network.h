@@ -9,6 +9,12 @@ typedef struct {
     size_t size;
 } NetworkBuffer;
 
+// HTTP cache validators of a downloaded resource; empty when not sent
+typedef struct {
+    char etag[128];
+    char last_modified[64];
+} NetworkValidators;
+
 // Network management functions
 bool network_init(void);
 void network_cleanup(void);
@@ -20,6 +26,8 @@ void network_get_system_proxy(char* proxy_url, size_t max_len);
 
 // Content download functions
 NetworkBuffer* network_download(const char* url);
+long network_download_revalidate(const char* url, NetworkValidators* validators,
+                                 NetworkBuffer** body);
 void network_buffer_free(NetworkBuffer* buffer);
 void fetch_playlist(const char* url);
 
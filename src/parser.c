@@ -56,6 +56,9 @@ static void parse_attributes(const char* line, PlaylistItem* item) {
             else if (strcmp(token, "language") == 0) {
                 item->language = strdup(value);
             }
+            else if (strcmp(token, "tvg-rating") == 0) {
+                item->age_rating = atoi(value);
+            }
         }
         token = strtok(NULL, " ");
     }
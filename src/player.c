@@ -1,4 +1,6 @@
 #include "player.h"
+#include "spsc_queue.h"
+#include "texture_registry.h"
 
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
@@ -9,10 +11,28 @@
 #include <libavutil/imgutils.h>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_audio.h>
+#include <math.h>
+#include <stdlib.h>
 #include <string.h>
 
-// Forward declarations
-static void playback_thread_func(void* arg);
+#define PIPELINE_STACK_SIZE 0x20000       // Decoders need more than the default
+#define PIPELINE_VIDEO_PACKETS 256
+#define PIPELINE_AUDIO_PACKETS 512
+#define PIPELINE_VIDEO_FRAMES 8
+#define PIPELINE_AUDIO_QUEUE_MS 250        // Output queued ahead of the device
+#define PIPELINE_IDLE_NS 1000000LL         // Wait for a queue, 1 ms
+#define PIPELINE_RETRY_NS 10000000LL       // Wait after a failed read, 10 ms
+#define PIPELINE_HOLD_NS 10000000LL        // Longest wait on an early frame, 10 ms
+#define PIPELINE_SYNC_EARLY 0.002          // Shown when due within this, seconds
+#define PIPELINE_SYNC_JUMP 10.0            // An offset this large is a timestamp jump
+#define PIPELINE_SYNC_PULL 0.001           // Audio position step read as a device pull
+#define PIPELINE_SYNC_FRAME (1.0 / 25.0)   // Frame duration when the stream has no rate
+#define PIPELINE_SYNC_SMOOTHING 0.1        // Weight of each frame in the mean offset
+
+// Stands in a packet or frame queue for a seek: everything after it comes
+// from the new position
+static char pipeline_flush;
+#define PIPELINE_FLUSH ((void*)&pipeline_flush)
 
 struct FFmpegContext {
     AVFormatContext* format_ctx;
@@ -22,8 +42,6 @@ struct FFmpegContext {
     int audio_stream_idx;
     struct SwsContext* sws_ctx;
     SwrContext* swr_ctx;
-    AVFrame* frame;
-    AVPacket* packet;
 };
 
 struct SDLContext {
@@ -34,6 +52,71 @@ struct SDLContext {
     SDL_AudioSpec audio_spec;
 };
 
+// Pipeline thread slots
+enum {
+    PIPELINE_DEMUX,
+    PIPELINE_VIDEO,
+    PIPELINE_AUDIO,
+    PIPELINE_RENDER,
+    PIPELINE_THREAD_COUNT
+};
+
+struct PipelineContext {
+    Thread threads[PIPELINE_THREAD_COUNT];
+    bool started[PIPELINE_THREAD_COUNT];
+    SpscQueue video_packets;     // Demux to video decode
+    SpscQueue audio_packets;     // Demux to audio decode
+    SpscQueue video_frames;      // Video decode to render, YUV420P
+    SDL_atomic_t stop;
+    SDL_atomic_t paused;
+    SDL_atomic_t seeks;          // Flushes queued by demux
+    bool seek_requested;         // Under state_mutex, taken by demux
+    double seek_position;
+    PlayerSyncStats sync;        // Under state_mutex, written by render
+    
+    // Audio clock, written by the audio thread. The end time and the device
+    // queue are read together under clock_mutex.
+    Mutex clock_mutex;
+    double audio_end;            // Stream time just past the last queued sample
+    int audio_serial;            // Flushes seen by audio
+    double audio_bytes_per_second;
+    double audio_latency;        // Held by the device beyond its queue, seconds
+};
+
+// Master clock as the render thread follows it. The audio device position
+// is used once audio from the same seek is queued; until then, and for
+// streams without audio, wall time from the first frame shown.
+struct SyncClock {
+    int serial;                  // Flushes seen by render
+    bool audio_valid;
+    double audio_position;       // Device position at its last pull
+    Uint64 audio_time;           // When that pull was seen
+    bool system_valid;
+    double system_position;      // Stream time at system_time
+    Uint64 system_time;
+};
+
+// Forward declarations
+static bool pipeline_start(Player* player);
+static bool pipeline_stop(Player* player);
+static bool pipeline_start_thread(Player* player, int index, ThreadFunc func,
+                                  int priority, int core);
+static void pipeline_drain(Player* player);
+static void pipeline_fail(Player* player, PlayerError error);
+static bool pipeline_stopping(Player* player);
+static bool pipeline_push(Player* player, SpscQueue* queue, void* item);
+static int pipeline_interrupt(void* opaque);
+static void demux_thread_func(void* arg);
+static void video_thread_func(void* arg);
+static void audio_thread_func(void* arg);
+static void render_thread_func(void* arg);
+static AVFrame* video_output_frame(struct FFmpegContext* fctx, AVFrame* decoded);
+static void sync_clock_reset(struct SyncClock* clock);
+static double sync_clock_get(Player* player, struct SyncClock* clock, double pts,
+                             bool* audio_clock);
+static void sync_record(PlayerSyncStats* stats, double offset, bool dropped,
+                        bool held, bool audio_clock);
+
 static const char* error_strings[] = {
     "No error",
     "Memory allocation failed",
@@ -101,20 +184,50 @@ Player* player_create(void) {
         return NULL;
     }
 
+    // Initialize the pipeline queues, kept for the player's lifetime
+    struct PipelineContext* pctx = calloc(1, sizeof(struct PipelineContext));
+    if (!pctx ||
+        !spsc_queue_init(&pctx->video_packets, PIPELINE_VIDEO_PACKETS) ||
+        !spsc_queue_init(&pctx->audio_packets, PIPELINE_AUDIO_PACKETS) ||
+        !spsc_queue_init(&pctx->video_frames, PIPELINE_VIDEO_FRAMES)) {
+        player->last_error = PLAYER_ERROR_MEMORY;
+        if (pctx) {
+            spsc_queue_free(&pctx->video_packets);
+            spsc_queue_free(&pctx->audio_packets);
+            spsc_queue_free(&pctx->video_frames);
+            free(pctx);
+        }
+        SDL_Quit();
+        free(player->sdl_ctx);
+        free(player->ffmpeg_ctx);
+        free(player);
+        return NULL;
+    }
+    mutexInit(&pctx->clock_mutex);
+    player->pipeline_ctx = pctx;
+
     return player;
 }
 
 void player_free(Player* player) {
     if (!player) return;
 
-    // Stop playback if running
-    if (player->state == PLAYER_STATE_PLAYING || 
-        player->state == PLAYER_STATE_PAUSED) {
+    // Stop playback if running; threads left by an error are joined too
+    if (player->state != PLAYER_STATE_STOPPED) {
         player_stop(player);
     }
 
     struct FFmpegContext* fctx = (struct FFmpegContext*)player->ffmpeg_ctx;
     struct SDLContext* sctx = (struct SDLContext*)player->sdl_ctx;
+    struct PipelineContext* pctx = (struct PipelineContext*)player->pipeline_ctx;
+
+    // Cleanup pipeline; stopping drained the queues
+    if (pctx) {
+        spsc_queue_free(&pctx->video_packets);
+        spsc_queue_free(&pctx->audio_packets);
+        spsc_queue_free(&pctx->video_frames);
+        free(pctx);
+    }
 
     // Cleanup FFmpeg
     if (fctx) {
@@ -139,14 +252,6 @@ void player_free(Player* player) {
             swr_free(&fctx->swr_ctx);
         }
 
-        // Free frame and packet
-        if (fctx->frame) {
-            av_frame_free(&fctx->frame);
-        }
-        if (fctx->packet) {
-            av_packet_free(&fctx->packet);
-        }
-
         free(fctx);
     }
 
@@ -161,7 +266,7 @@ void player_free(Player* player) {
 
         // Destroy video resources
         if (sctx->texture) {
-            SDL_DestroyTexture(sctx->texture);
+            texture_registry_destroy(sctx->texture);
         }
         if (sctx->renderer) {
             SDL_DestroyRenderer(sctx->renderer);
@@ -219,6 +324,10 @@ bool player_load(Player* player, const PlaylistItem* item) {
         return false;
     }
 
+    // Lets stop abandon a read blocked on the network
+    fctx->format_ctx->interrupt_callback.callback = pipeline_interrupt;
+    fctx->format_ctx->interrupt_callback.opaque = player->pipeline_ctx;
+
     // Find video and audio streams
     fctx->video_stream_idx = av_find_best_stream(fctx->format_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
     fctx->audio_stream_idx = av_find_best_stream(fctx->format_ctx, AVMEDIA_TYPE_AUDIO, -1, -1, NULL, 0);
@@ -269,11 +378,12 @@ bool player_load(Player* player, const PlaylistItem* item) {
             return false;
         }
 
-        sctx->texture = SDL_CreateTexture(sctx->renderer,
-                                        SDL_PIXELFORMAT_YV12,
-                                        SDL_TEXTUREACCESS_STREAMING,
-                                        fctx->video_codec_ctx->width,
-                                        fctx->video_codec_ctx->height);
+        sctx->texture = texture_registry_create(sctx->renderer,
+                                                TEXTURE_CLASS_VIDEO,
+                                                SDL_PIXELFORMAT_YV12,
+                                                SDL_TEXTUREACCESS_STREAMING,
+                                                fctx->video_codec_ctx->width,
+                                                fctx->video_codec_ctx->height);
         
         if (!sctx->texture) {
             player->last_error = PLAYER_ERROR_SDL;
@@ -329,7 +439,7 @@ bool player_load(Player* player, const PlaylistItem* item) {
         if (!sctx->audio_dev) {
             player->last_error = PLAYER_ERROR_SDL;
             // Clean up all previously allocated resources
-            if (sctx->texture) SDL_DestroyTexture(sctx->texture);
+            if (sctx->texture) texture_registry_destroy(sctx->texture);
             if (sctx->renderer) SDL_DestroyRenderer(sctx->renderer);
             if (sctx->window) SDL_DestroyWindow(sctx->window);
             if (fctx->video_codec_ctx) avcodec_free_context(&fctx->video_codec_ctx);
@@ -359,12 +469,12 @@ bool player_load(Player* player, const PlaylistItem* item) {
         }
     }
 
-    // Allocate frame and packet
-    fctx->frame = av_frame_alloc();
-    fctx->packet = av_packet_alloc();
-    
     player->state = PLAYER_STATE_STOPPED;
     player->current_time = 0.0;
+    
+    // Sync counters are per stream
+    struct PipelineContext* pctx = (struct PipelineContext*)player->pipeline_ctx;
+    memset(&pctx->sync, 0, sizeof(pctx->sync));
 
     return true;
 }
@@ -375,34 +485,31 @@ bool player_play(Player* player) {
         return false;
     }
     
-    mutexLock(&player->state_mutex);
-    player->state = PLAYER_STATE_PLAYING;
+    struct SDLContext* sctx = (struct SDLContext*)player->sdl_ctx;
+    struct PipelineContext* pctx = (struct PipelineContext*)player->pipeline_ctx;
     
-    // Start playback thread
-    Result rc = threadCreate(&player->playback_thread, 
-                           playback_thread_func, 
-                           player, 
-                           NULL, 
-                           0x4000, // Stack size
-                           0x2B,   // Priority
-                           -2);    // Core -2 = don't care
-    if (R_FAILED(rc)) {
-        player->last_error = PLAYER_ERROR_THREAD;
-        player->state = PLAYER_STATE_ERROR;
-        mutexUnlock(&player->state_mutex);
-        return false;
+    // Threads of a run that failed have exited or are about to
+    if (player->state == PLAYER_STATE_ERROR) {
+        pipeline_stop(player);
     }
     
-    rc = threadStart(&player->playback_thread);
-    if (R_FAILED(rc)) {
+    mutexLock(&player->state_mutex);
+    bool resume = player->state == PLAYER_STATE_PAUSED;
+    player->state = PLAYER_STATE_PLAYING;
+    mutexUnlock(&player->state_mutex);
+    
+    // Paused threads are still running
+    if (!resume && !pipeline_start(player)) {
+        mutexLock(&player->state_mutex);
         player->last_error = PLAYER_ERROR_THREAD;
         player->state = PLAYER_STATE_ERROR;
-        threadClose(&player->playback_thread);
         mutexUnlock(&player->state_mutex);
+        pipeline_stop(player);
         return false;
     }
     
-    mutexUnlock(&player->state_mutex);
+    SDL_AtomicSet(&pctx->paused, 0);
+    SDL_PauseAudioDevice(sctx->audio_dev, 0);
     return true;
 }
 
@@ -412,11 +519,16 @@ bool player_pause(Player* player) {
         return false;
     }
     
+    struct PipelineContext* pctx = (struct PipelineContext*)player->pipeline_ctx;
+    
     mutexLock(&player->state_mutex);
     player->state = PLAYER_STATE_PAUSED;
-    SDL_PauseAudioDevice(((struct SDLContext*)player->sdl_ctx)->audio_dev, 1);
     mutexUnlock(&player->state_mutex);
     
+    // Decoding carries on until the queues are full
+    SDL_AtomicSet(&pctx->paused, 1);
+    SDL_PauseAudioDevice(((struct SDLContext*)player->sdl_ctx)->audio_dev, 1);
+    
     return true;
 }
 
@@ -429,23 +541,21 @@ bool player_stop(Player* player) {
     mutexLock(&player->state_mutex);
     player->state = PLAYER_STATE_STOPPED;
     player->current_time = 0.0;
+    mutexUnlock(&player->state_mutex);
     
     // Stop audio playback
     SDL_PauseAudioDevice(((struct SDLContext*)player->sdl_ctx)->audio_dev, 1);
-    SDL_ClearQueuedAudio(((struct SDLContext*)player->sdl_ctx)->audio_dev);
     
-    // Wait for playback thread to finish
-    Result rc = threadWaitForExit(&player->playback_thread);
-    if (R_FAILED(rc)) {
+    // Joined without the lock, which the threads take to publish progress
+    bool stopped = pipeline_stop(player);
+    if (!stopped) {
         player->last_error = PLAYER_ERROR_THREAD;
-        mutexUnlock(&player->state_mutex);
-        return false;
     }
     
-    threadClose(&player->playback_thread);
-    mutexUnlock(&player->state_mutex);
+    // The audio thread may have queued more until it saw the stop
+    SDL_ClearQueuedAudio(((struct SDLContext*)player->sdl_ctx)->audio_dev);
     
-    return true;
+    return stopped;
 }
 
 double player_get_duration(const Player* player) {
@@ -457,7 +567,13 @@ double player_get_duration(const Player* player) {
 
 double player_get_position(const Player* player) {
     if (!player) return 0.0;
-    return player->current_time;
+    
+    // Written by the render thread
+    Player* locked = (Player*)player;
+    mutexLock(&locked->state_mutex);
+    double position = player->current_time;
+    mutexUnlock(&locked->state_mutex);
+    return position;
 }
 
 bool player_seek(Player* player, double position) {
@@ -466,14 +582,22 @@ bool player_seek(Player* player, double position) {
         return false;
     }
     
-    mutexLock(&player->state_mutex);
     struct FFmpegContext* fctx = (struct FFmpegContext*)player->ffmpeg_ctx;
+    struct PipelineContext* pctx = (struct PipelineContext*)player->pipeline_ctx;
     
-    int64_t timestamp = position * AV_TIME_BASE;
-    if (av_seek_frame(fctx->format_ctx, -1, timestamp, AVSEEK_FLAG_ANY) < 0) {
-        player->last_error = PLAYER_ERROR_STREAM_INFO;
-        mutexUnlock(&player->state_mutex);
-        return false;
+    mutexLock(&player->state_mutex);
+    
+    // A running demux thread owns the format context; it seeks between reads
+    if (pctx->started[PIPELINE_DEMUX]) {
+        pctx->seek_requested = true;
+        pctx->seek_position = position;
+    } else {
+        int64_t timestamp = position * AV_TIME_BASE;
+        if (av_seek_frame(fctx->format_ctx, -1, timestamp, AVSEEK_FLAG_ANY) < 0) {
+            player->last_error = PLAYER_ERROR_STREAM_INFO;
+            mutexUnlock(&player->state_mutex);
+            return false;
+        }
     }
     
     player->current_time = position;
@@ -482,85 +606,561 @@ bool player_seek(Player* player, double position) {
     return true;
 } 
 
-static void playback_thread_func(void* arg) {
-    Player* player = (Player*)arg;
+PlayerSyncStats player_get_sync_stats(const Player* player) {
+    PlayerSyncStats stats;
+    memset(&stats, 0, sizeof(stats));
+    if (!player) return stats;
+    
+    // Written by the render thread with each frame
+    struct PipelineContext* pctx = (struct PipelineContext*)player->pipeline_ctx;
+    Player* locked = (Player*)player;
+    mutexLock(&locked->state_mutex);
+    stats = pctx->sync;
+    mutexUnlock(&locked->state_mutex);
+    return stats;
+}
+
+static bool pipeline_start(Player* player) {
     struct FFmpegContext* fctx = (struct FFmpegContext*)player->ffmpeg_ctx;
     struct SDLContext* sctx = (struct SDLContext*)player->sdl_ctx;
+    struct PipelineContext* pctx = (struct PipelineContext*)player->pipeline_ctx;
+    
+    SDL_AtomicSet(&pctx->stop, 0);
+    SDL_AtomicSet(&pctx->paused, 0);
+    SDL_AtomicSet(&pctx->seeks, 0);
+    
+    // No thread is running yet to race these
+    pctx->audio_end = NAN;
+    pctx->audio_serial = 0;
+    if (fctx->audio_stream_idx >= 0) {
+        int channels = fctx->audio_codec_ctx->ch_layout.nb_channels;
+        pctx->audio_bytes_per_second = (double)sctx->audio_spec.freq * channels * 2;
+        pctx->audio_latency = (double)sctx->audio_spec.samples / sctx->audio_spec.freq;
+    }
+    
+    // Consumers first, so nothing is queued without a thread to take it.
+    // Audio and video decode get a core each; priority 0x2B is above the UI
+    // for the stages feeding the outputs.
+    if (fctx->audio_stream_idx >= 0 &&
+        !pipeline_start_thread(player, PIPELINE_AUDIO, audio_thread_func, 0x2B, 2)) {
+        return false;
+    }
+    if (fctx->video_stream_idx >= 0 &&
+        (!pipeline_start_thread(player, PIPELINE_RENDER, render_thread_func, 0x2B, -2) ||
+         !pipeline_start_thread(player, PIPELINE_VIDEO, video_thread_func, 0x2C, 1))) {
+        return false;
+    }
+    return pipeline_start_thread(player, PIPELINE_DEMUX, demux_thread_func, 0x2C, -2);
+}
+
+static bool pipeline_stop(Player* player) {
+    struct PipelineContext* pctx = (struct PipelineContext*)player->pipeline_ctx;
+    struct FFmpegContext* fctx = (struct FFmpegContext*)player->ffmpeg_ctx;
+    bool stopped = true;
+    
+    // Every wait in the threads is bounded, so they see this within a
+    // packet or frame
+    SDL_AtomicSet(&pctx->stop, 1);
+    for (int i = 0; i < PIPELINE_THREAD_COUNT; i++) {
+        if (!pctx->started[i]) continue;
+        
+        if (R_FAILED(threadWaitForExit(&pctx->threads[i]))) {
+            stopped = false;
+        }
+        threadClose(&pctx->threads[i]);
+        pctx->started[i] = false;
+    }
+    
+    pipeline_drain(player);
+    
+    // Reads outside a run, like a seek while stopped, are not interrupted
+    SDL_AtomicSet(&pctx->stop, 0);
+    
+    // The next run starts from clean decoders
+    if (fctx->video_codec_ctx) avcodec_flush_buffers(fctx->video_codec_ctx);
+    if (fctx->audio_codec_ctx) avcodec_flush_buffers(fctx->audio_codec_ctx);
+    
+    mutexLock(&player->state_mutex);
+    pctx->seek_requested = false;
+    mutexUnlock(&player->state_mutex);
+    
+    return stopped;
+}
+
+static bool pipeline_start_thread(Player* player, int index, ThreadFunc func,
+                                  int priority, int core) {
+    struct PipelineContext* pctx = (struct PipelineContext*)player->pipeline_ctx;
+    Thread* thread = &pctx->threads[index];
+    
+    if (R_FAILED(threadCreate(thread, func, player, NULL, PIPELINE_STACK_SIZE,
+                              priority, core))) {
+        return false;
+    }
+    if (R_FAILED(threadStart(thread))) {
+        threadClose(thread);
+        return false;
+    }
+    
+    pctx->started[index] = true;
+    return true;
+}
+
+static void pipeline_drain(Player* player) {
+    struct PipelineContext* pctx = (struct PipelineContext*)player->pipeline_ctx;
+    void* item;
+    
+    // Only called with every thread joined, so this is the sole consumer
+    while ((item = spsc_queue_pop(&pctx->video_packets))) {
+        if (item != PIPELINE_FLUSH) av_packet_free((AVPacket**)&item);
+    }
+    while ((item = spsc_queue_pop(&pctx->audio_packets))) {
+        if (item != PIPELINE_FLUSH) av_packet_free((AVPacket**)&item);
+    }
+    while ((item = spsc_queue_pop(&pctx->video_frames))) {
+        if (item != PIPELINE_FLUSH) av_frame_free((AVFrame**)&item);
+    }
+}
+
+static void pipeline_fail(Player* player, PlayerError error) {
+    struct PipelineContext* pctx = (struct PipelineContext*)player->pipeline_ctx;
+    
+    // The other threads wind down; the UI sees the error state and stops
+    mutexLock(&player->state_mutex);
+    player->last_error = error;
+    player->state = PLAYER_STATE_ERROR;
+    mutexUnlock(&player->state_mutex);
+    
+    SDL_AtomicSet(&pctx->stop, 1);
+}
+
+static bool pipeline_stopping(Player* player) {
+    struct PipelineContext* pctx = (struct PipelineContext*)player->pipeline_ctx;
+    return SDL_AtomicGet(&pctx->stop) != 0;
+}
+
+static bool pipeline_push(Player* player, SpscQueue* queue, void* item) {
+    // A full queue holds the producer back to the pace of its consumer
+    while (!spsc_queue_push(queue, item)) {
+        if (pipeline_stopping(player)) return false;
+        svcSleepThread(PIPELINE_IDLE_NS);
+    }
+    return true;
+}
+
+static int pipeline_interrupt(void* opaque) {
+    struct PipelineContext* pctx = (struct PipelineContext*)opaque;
+    return SDL_AtomicGet(&pctx->stop) != 0;
+}
+
+static void demux_thread_func(void* arg) {
+    Player* player = (Player*)arg;
+    struct FFmpegContext* fctx = (struct FFmpegContext*)player->ffmpeg_ctx;
+    struct PipelineContext* pctx = (struct PipelineContext*)player->pipeline_ctx;
+    AVPacket* packet = NULL;
     
-    while (player->state == PLAYER_STATE_PLAYING) {
+    while (!pipeline_stopping(player)) {
+        // Seek between reads, then tell each decoder to drop what it holds
         mutexLock(&player->state_mutex);
+        bool seek = pctx->seek_requested;
+        double position = pctx->seek_position;
+        pctx->seek_requested = false;
+        mutexUnlock(&player->state_mutex);
         
-        // Read packet
-        if (av_read_frame(fctx->format_ctx, fctx->packet) >= 0) {
-            // Handle errors in video/audio processing
-            int ret;
-            if (fctx->packet->stream_index == fctx->video_stream_idx) {
-                ret = avcodec_send_packet(fctx->video_codec_ctx, fctx->packet);
-                if (ret < 0) {
-                    player->last_error = PLAYER_ERROR_VIDEO_CODEC;
-                    player->state = PLAYER_STATE_ERROR;
-                    mutexUnlock(&player->state_mutex);
-                    break;
+        if (seek) {
+            int64_t timestamp = position * AV_TIME_BASE;
+            if (av_seek_frame(fctx->format_ctx, -1, timestamp, AVSEEK_FLAG_ANY) >= 0) {
+                // Counted first, so the stages drop what is queued ahead
+                // of the flush instead of playing it out
+                SDL_AtomicAdd(&pctx->seeks, 1);
+                if (fctx->video_stream_idx >= 0) {
+                    pipeline_push(player, &pctx->video_packets, PIPELINE_FLUSH);
                 }
-                // Handle video packet
-                if (avcodec_receive_frame(fctx->video_codec_ctx, fctx->frame) == 0) {
-                    // Convert frame to SDL texture
-                    SDL_UpdateTexture(sctx->texture, NULL, 
-                                    fctx->frame->data[0], 
-                                    fctx->frame->linesize[0]);
-                    
-                    SDL_RenderClear(sctx->renderer);
-                    SDL_RenderCopy(sctx->renderer, sctx->texture, NULL, NULL);
-                    SDL_RenderPresent(sctx->renderer);
-                    
-                    // Update playback time
-                    player->current_time = fctx->frame->pts * 
-                        av_q2d(fctx->format_ctx->streams[fctx->video_stream_idx]->time_base);
+                if (fctx->audio_stream_idx >= 0) {
+                    pipeline_push(player, &pctx->audio_packets, PIPELINE_FLUSH);
                 }
             }
-            // Handle audio packet
-            else if (fctx->packet->stream_index == fctx->audio_stream_idx) {
-                ret = avcodec_send_packet(fctx->audio_codec_ctx, fctx->packet);
-                if (ret < 0) {
-                    player->last_error = PLAYER_ERROR_AUDIO_CODEC;
-                    player->state = PLAYER_STATE_ERROR;
-                    mutexUnlock(&player->state_mutex);
-                    break;
-                }
-                while (avcodec_receive_frame(fctx->audio_codec_ctx, fctx->frame) == 0) {
-                    // Convert audio format if needed
-                    uint8_t* audio_buf;
-                    int audio_buf_size;
-                    
-                    swr_convert(fctx->swr_ctx,
-                              &audio_buf,
-                              fctx->frame->nb_samples,
-                              (const uint8_t**)fctx->frame->data,
-                              fctx->frame->nb_samples);
-                    
-                    audio_buf_size = av_samples_get_buffer_size(NULL,
-                                                                fctx->audio_codec_ctx->ch_layout.nb_channels,
-                                                                fctx->frame->nb_samples,
-                                                                AV_SAMPLE_FMT_S16,
-                                                                1);
-                    
-                    // Queue audio to SDL
-                    SDL_QueueAudio(sctx->audio_dev, audio_buf, audio_buf_size);
-                }
+        }
+        
+        if (!packet) {
+            packet = av_packet_alloc();
+            if (!packet) {
+                pipeline_fail(player, PLAYER_ERROR_MEMORY);
+                break;
+            }
+        }
+        
+        // End of stream or a stalled network: nothing to queue, try again
+        if (av_read_frame(fctx->format_ctx, packet) < 0) {
+            svcSleepThread(PIPELINE_RETRY_NS);
+            continue;
+        }
+        
+        SpscQueue* queue = NULL;
+        if (packet->stream_index == fctx->video_stream_idx) {
+            queue = &pctx->video_packets;
+        } else if (packet->stream_index == fctx->audio_stream_idx) {
+            queue = &pctx->audio_packets;
+        }
+        
+        // Queued packets belong to the decoder; the rest are reused
+        if (queue && pipeline_push(player, queue, packet)) {
+            packet = NULL;
+        } else {
+            av_packet_unref(packet);
+        }
+    }
+    
+    av_packet_free(&packet);
+    threadExit();
+}
+
+static void video_thread_func(void* arg) {
+    Player* player = (Player*)arg;
+    struct FFmpegContext* fctx = (struct FFmpegContext*)player->ffmpeg_ctx;
+    struct PipelineContext* pctx = (struct PipelineContext*)player->pipeline_ctx;
+    AVFrame* decoded = av_frame_alloc();
+    int flushes = 0;
+    
+    if (!decoded) {
+        pipeline_fail(player, PLAYER_ERROR_MEMORY);
+    }
+    
+    while (decoded && !pipeline_stopping(player)) {
+        AVPacket* packet = spsc_queue_pop(&pctx->video_packets);
+        if (!packet) {
+            svcSleepThread(PIPELINE_IDLE_NS);
+            continue;
+        }
+        
+        if (packet == PIPELINE_FLUSH) {
+            avcodec_flush_buffers(fctx->video_codec_ctx);
+            pipeline_push(player, &pctx->video_frames, PIPELINE_FLUSH);
+            flushes++;
+            continue;
+        }
+        if (flushes != SDL_AtomicGet(&pctx->seeks)) {
+            av_packet_free(&packet);
+            continue;
+        }
+        
+        int ret = avcodec_send_packet(fctx->video_codec_ctx, packet);
+        av_packet_free(&packet);
+        if (ret < 0) {
+            pipeline_fail(player, PLAYER_ERROR_VIDEO_CODEC);
+            break;
+        }
+        
+        while (avcodec_receive_frame(fctx->video_codec_ctx, decoded) == 0) {
+            AVFrame* frame = video_output_frame(fctx, decoded);
+            if (!frame) {
+                pipeline_fail(player, PLAYER_ERROR_MEMORY);
+                break;
+            }
+            if (!pipeline_push(player, &pctx->video_frames, frame)) {
+                av_frame_free(&frame);
+                break;
+            }
+        }
+    }
+    
+    av_frame_free(&decoded);
+    threadExit();
+}
+
+static void audio_thread_func(void* arg) {
+    Player* player = (Player*)arg;
+    struct FFmpegContext* fctx = (struct FFmpegContext*)player->ffmpeg_ctx;
+    struct SDLContext* sctx = (struct SDLContext*)player->sdl_ctx;
+    struct PipelineContext* pctx = (struct PipelineContext*)player->pipeline_ctx;
+    AVFrame* frame = av_frame_alloc();
+    uint8_t* buffer = NULL;
+    unsigned int buffer_size = 0;
+    
+    // Output keeps the input layout, as the resampler was set up
+    int channels = fctx->audio_codec_ctx->ch_layout.nb_channels;
+    int bytes_per_sample = channels * 2;
+    Uint32 queue_limit = (Uint32)(sctx->audio_spec.freq * bytes_per_sample / 1000 *
+                                  PIPELINE_AUDIO_QUEUE_MS);
+    double time_base = av_q2d(fctx->format_ctx->streams[fctx->audio_stream_idx]->time_base);
+    
+    if (!frame) {
+        pipeline_fail(player, PLAYER_ERROR_MEMORY);
+    }
+    
+    while (frame && !pipeline_stopping(player)) {
+        // The device queue is the last stage; decode only as it drains.
+        // Packets from before a seek are dropped without waiting on it.
+        bool current = pctx->audio_serial == SDL_AtomicGet(&pctx->seeks);
+        if (current && SDL_GetQueuedAudioSize(sctx->audio_dev) > queue_limit) {
+            svcSleepThread(PIPELINE_IDLE_NS);
+            continue;
+        }
+        
+        AVPacket* packet = spsc_queue_pop(&pctx->audio_packets);
+        if (!packet) {
+            svcSleepThread(PIPELINE_IDLE_NS);
+            continue;
+        }
+        
+        if (packet == PIPELINE_FLUSH) {
+            avcodec_flush_buffers(fctx->audio_codec_ctx);
+            
+            // Video keeps to wall time until audio from the new position
+            mutexLock(&pctx->clock_mutex);
+            SDL_ClearQueuedAudio(sctx->audio_dev);
+            pctx->audio_end = NAN;
+            pctx->audio_serial++;
+            mutexUnlock(&pctx->clock_mutex);
+            continue;
+        }
+        if (!current) {
+            av_packet_free(&packet);
+            continue;
+        }
+        
+        int ret = avcodec_send_packet(fctx->audio_codec_ctx, packet);
+        av_packet_free(&packet);
+        if (ret < 0) {
+            pipeline_fail(player, PLAYER_ERROR_AUDIO_CODEC);
+            break;
+        }
+        
+        while (avcodec_receive_frame(fctx->audio_codec_ctx, frame) == 0) {
+            // Convert audio format; the buffer grows to the largest frame
+            int samples = swr_get_out_samples(fctx->swr_ctx, frame->nb_samples);
+            av_fast_malloc(&buffer, &buffer_size, (size_t)samples * bytes_per_sample);
+            if (!buffer) {
+                pipeline_fail(player, PLAYER_ERROR_MEMORY);
+                break;
+            }
+            
+            int converted = swr_convert(fctx->swr_ctx, &buffer, samples,
+                                        (const uint8_t**)frame->data, frame->nb_samples);
+            if (converted <= 0) continue;
+            
+            // Samples without a timestamp follow on from the last ones
+            double start = frame->best_effort_timestamp != AV_NOPTS_VALUE
+                               ? frame->best_effort_timestamp * time_base
+                               : pctx->audio_end;
+            
+            mutexLock(&pctx->clock_mutex);
+            SDL_QueueAudio(sctx->audio_dev, buffer, (Uint32)(converted * bytes_per_sample));
+            pctx->audio_end = start + (double)converted / sctx->audio_spec.freq;
+            double played = pctx->audio_end -
+                            SDL_GetQueuedAudioSize(sctx->audio_dev) / pctx->audio_bytes_per_second -
+                            pctx->audio_latency;
+            mutexUnlock(&pctx->clock_mutex);
+            
+            // Nothing is rendered to take the position from
+            if (fctx->video_stream_idx < 0 && !isnan(played)) {
+                mutexLock(&player->state_mutex);
+                player->current_time = played;
+                mutexUnlock(&player->state_mutex);
             }
+        }
+    }
+    
+    av_freep(&buffer);
+    av_frame_free(&frame);
+    threadExit();
+}
+
+static void render_thread_func(void* arg) {
+    Player* player = (Player*)arg;
+    struct FFmpegContext* fctx = (struct FFmpegContext*)player->ffmpeg_ctx;
+    struct SDLContext* sctx = (struct SDLContext*)player->sdl_ctx;
+    struct PipelineContext* pctx = (struct PipelineContext*)player->pipeline_ctx;
+    AVStream* stream = fctx->format_ctx->streams[fctx->video_stream_idx];
+    double time_base = av_q2d(stream->time_base);
+    struct SyncClock clock = {0};
+    double last_pts = NAN;
+    bool held = false;
+    
+    // The nominal rate sets how late a frame may be before it is dropped
+    AVRational rate = av_guess_frame_rate(fctx->format_ctx, stream, NULL);
+    double frame_duration = rate.num > 0 && rate.den > 0 ? (double)rate.den / rate.num
+                                                         : PIPELINE_SYNC_FRAME;
+    mutexLock(&player->state_mutex);
+    pctx->sync.frame_duration = frame_duration;
+    mutexUnlock(&player->state_mutex);
+    
+    while (!pipeline_stopping(player)) {
+        // The device stops with us, and the clock picks up from it on resume
+        if (SDL_AtomicGet(&pctx->paused)) {
+            sync_clock_reset(&clock);
+            svcSleepThread(PIPELINE_IDLE_NS);
+            continue;
+        }
+        
+        AVFrame* frame = spsc_queue_peek(&pctx->video_frames);
+        if (!frame) {
+            svcSleepThread(PIPELINE_IDLE_NS);
+            continue;
+        }
+        
+        if (frame == PIPELINE_FLUSH) {
+            spsc_queue_pop(&pctx->video_frames);
+            sync_clock_reset(&clock);
+            clock.serial++;
+            last_pts = NAN;
+            held = false;
+            continue;
+        }
+        
+        // Pictures from before a seek go without being shown
+        if (clock.serial != SDL_AtomicGet(&pctx->seeks)) {
+            spsc_queue_pop(&pctx->video_frames);
+            av_frame_free(&frame);
+            continue;
+        }
+        
+        // Frames without a timestamp follow on from the last one
+        double pts = frame->best_effort_timestamp != AV_NOPTS_VALUE
+                         ? frame->best_effort_timestamp * time_base
+                         : last_pts + frame_duration;
+        bool audio_clock = false;
+        double delay = isnan(pts) ? 0.0 : pts - sync_clock_get(player, &clock, pts, &audio_clock);
+        
+        // Far out either way is a discontinuity, not drift: show the frame
+        // and keep time from it
+        if (fabs(delay) > PIPELINE_SYNC_JUMP) {
+            sync_clock_reset(&clock);
+            delay = 0.0;
+        }
+        
+        // Early: wait in short steps, so pause and stop are still seen
+        if (delay > PIPELINE_SYNC_EARLY) {
+            Sint64 wait = (Sint64)(delay * 1e9);
+            svcSleepThread(wait < PIPELINE_HOLD_NS ? wait : PIPELINE_HOLD_NS);
+            held = true;
+            continue;
+        }
+        
+        spsc_queue_pop(&pctx->video_frames);
+        last_pts = pts;
+        
+        // More than a frame late with the next one ready: skip to it
+        bool dropped = delay < -frame_duration && spsc_queue_count(&pctx->video_frames) > 0;
+        if (!dropped) {
+            SDL_UpdateYUVTexture(sctx->texture, NULL,
+                                 frame->data[0], frame->linesize[0],
+                                 frame->data[1], frame->linesize[1],
+                                 frame->data[2], frame->linesize[2]);
             
-            av_packet_unref(fctx->packet);
+            SDL_RenderClear(sctx->renderer);
+            SDL_RenderCopy(sctx->renderer, sctx->texture, NULL, NULL);
+            SDL_RenderPresent(sctx->renderer);
         }
         
+        mutexLock(&player->state_mutex);
+        sync_record(&pctx->sync, delay, dropped, held, audio_clock);
+        if (!dropped && !isnan(pts)) {
+            player->current_time = pts;
+        }
         mutexUnlock(&player->state_mutex);
         
-        // Small sleep to prevent CPU overuse
-        svcSleepThread(1000000LL); // 1ms
+        held = false;
+        av_frame_free(&frame);
     }
     
-    // Clean up thread resources
     threadExit();
-} 
+}
+
+static AVFrame* video_output_frame(struct FFmpegContext* fctx, AVFrame* decoded) {
+    AVFrame* frame = av_frame_alloc();
+    if (!frame) return NULL;
+    
+    // Pictures already in the texture's layout are handed over as they are
+    if (decoded->format == AV_PIX_FMT_YUV420P) {
+        av_frame_move_ref(frame, decoded);
+        return frame;
+    }
+    
+    // The decoder may settle on its format only with the first picture
+    fctx->sws_ctx = sws_getCachedContext(fctx->sws_ctx,
+                                         decoded->width, decoded->height, decoded->format,
+                                         decoded->width, decoded->height, AV_PIX_FMT_YUV420P,
+                                         SWS_BILINEAR, NULL, NULL, NULL);
+    
+    frame->format = AV_PIX_FMT_YUV420P;
+    frame->width = decoded->width;
+    frame->height = decoded->height;
+    if (!fctx->sws_ctx || av_frame_get_buffer(frame, 0) < 0) {
+        av_frame_unref(decoded);
+        av_frame_free(&frame);
+        return NULL;
+    }
+    
+    sws_scale(fctx->sws_ctx, (const uint8_t* const*)decoded->data, decoded->linesize,
+              0, decoded->height, frame->data, frame->linesize);
+    av_frame_copy_props(frame, decoded);
+    av_frame_unref(decoded);
+    return frame;
+}
+
+static void sync_clock_reset(struct SyncClock* clock) {
+    // Kept across resets: only a flush moves the render thread on
+    int serial = clock->serial;
+    memset(clock, 0, sizeof(*clock));
+    clock->serial = serial;
+}
+
+static double sync_clock_get(Player* player, struct SyncClock* clock, double pts,
+                             bool* audio_clock) {
+    struct SDLContext* sctx = (struct SDLContext*)player->sdl_ctx;
+    struct PipelineContext* pctx = (struct PipelineContext*)player->pipeline_ctx;
+    Uint64 now = SDL_GetPerformanceCounter();
+    double frequency = (double)SDL_GetPerformanceFrequency();
+    
+    mutexLock(&pctx->clock_mutex);
+    bool current = pctx->audio_serial == clock->serial && !isnan(pctx->audio_end);
+    double position = current ? pctx->audio_end -
+                                SDL_GetQueuedAudioSize(sctx->audio_dev) / pctx->audio_bytes_per_second -
+                                pctx->audio_latency
+                              : 0.0;
+    mutexUnlock(&pctx->clock_mutex);
+    
+    if (current) {
+        // The device takes its queue a buffer at a time. Between pulls the
+        // position runs on wall time, up to the end of what it was given.
+        if (!clock->audio_valid || fabs(position - clock->audio_position) > PIPELINE_SYNC_PULL) {
+            clock->audio_valid = true;
+            clock->audio_position = position;
+            clock->audio_time = now;
+        }
+        double run = (now - clock->audio_time) / frequency;
+        *audio_clock = true;
+        return clock->audio_position + (run < pctx->audio_latency ? run : pctx->audio_latency);
+    }
+    
+    if (!clock->system_valid) {
+        clock->system_valid = true;
+        clock->system_position = pts;
+        clock->system_time = now;
+    }
+    *audio_clock = false;
+    return clock->system_position + (now - clock->system_time) / frequency;
+}
+
+static void sync_record(PlayerSyncStats* stats, double offset, bool dropped,
+                        bool held, bool audio_clock) {
+    stats->audio_clock = audio_clock;
+    if (dropped) {
+        stats->frames_dropped++;
+        return;
+    }
+    
+    stats->av_offset = offset;
+    stats->av_offset_mean = stats->frames_presented == 0
+                                ? offset
+                                : stats->av_offset_mean +
+                                  (offset - stats->av_offset_mean) * PIPELINE_SYNC_SMOOTHING;
+    if (fabs(offset) > fabs(stats->av_offset_max)) {
+        stats->av_offset_max = offset;
+    }
+    stats->frames_presented++;
+    if (held) stats->frames_held++;
+}
 
 void player_play_item(Player* player, PlaylistItem* item) {
     // Existing play logic...
@@ -25,6 +25,19 @@ typedef enum {
     PLAYER_ERROR_THREAD
 } PlayerError;
 
+// A/V sync counters since the stream was loaded. Offsets are how far ahead
+// of the clock a frame was when shown, in seconds; negative is late.
+typedef struct {
+    double av_offset;             // Last frame shown
+    double av_offset_mean;        // Smoothed over recent frames
+    double av_offset_max;         // Largest either way
+    double frame_duration;        // Nominal, from the stream frame rate
+    Uint32 frames_presented;
+    Uint32 frames_dropped;        // Late, with a newer frame ready
+    Uint32 frames_held;           // Early, shown after a wait
+    bool audio_clock;             // Timed against audio output, not wall time
+} PlayerSyncStats;
+
 struct Player {
     PlayerState state;
     PlayerError last_error;
@@ -32,12 +45,33 @@ struct Player {
     double current_time;
     void* ffmpeg_ctx;
     void* sdl_ctx;
-    Mutex state_mutex;
-    Thread playback_thread;
+    void* pipeline_ctx;      // Decoding threads and the queues between them
+    Mutex state_mutex;       // State, error, time and seek requests
 };
 
 typedef struct Player Player;
 
+// Playback pipeline
+//
+// A demux thread reads packets and hands them to a video and an audio
+// decode thread; decoded pictures go on to a render thread. Each hand-off
+// is a bounded lock-free queue with one producer and one consumer. A full
+// queue makes its producer wait, so a slow stage holds back the ones before
+// it instead of growing memory, and the audio decoder waits on the device
+// queue the same way. The threads read stop and pause flags atomically and
+// take state_mutex only to publish the playing time or an error, so calls
+// from the UI only wait on short critical sections; stop joins the threads
+// without holding it.
+//
+// Audio is the master clock. The audio thread records the stream time just
+// past the last sample it queues; the device position is that time less the
+// audio still queued and the device buffer, and runs on wall time between
+// the device's pulls. The render thread peeks at each picture and holds it
+// until its timestamp is due, or drops it when more than a frame late with
+// the next one ready. Without audio, wall time from the first frame keeps
+// time. A seek is counted before its flush goes out, so every stage drops
+// what is queued ahead of the flush instead of playing it out.
+
 // Player functions
 Player* player_create(void);
 void player_free(Player* player);
@@ -49,6 +83,7 @@ double player_get_duration(const Player* player);
 double player_get_position(const Player* player);
 bool player_seek(Player* player, double position);
 SDL_Texture* player_get_video_texture(const Player* player);
+PlayerSyncStats player_get_sync_stats(const Player* player);
 
 // Add error handling functions
 const char* player_get_error_string(PlayerError error);
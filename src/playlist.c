@@ -1,4 +1,5 @@
 #include "playlist.h"
+#include "playlist_sort.h"
 #include "ui.h"
 #include "network.h"
 #include <stdlib.h>
@@ -19,6 +20,7 @@ Playlist* playlist_create(void) {
 
     playlist->count = 0;
     playlist->capacity = INITIAL_CAPACITY;
+    playlist->sort_index = NULL;
     
     return playlist;
 }
@@ -33,6 +35,7 @@ void playlist_free(Playlist* playlist) {
         free(playlist->items[i].logo);
     }
 
+    playlist_sort_invalidate(playlist);
     free(playlist->items);
     free(playlist);
 }
@@ -78,9 +81,29 @@ bool playlist_add_item(Playlist* playlist, const PlaylistItem* item) {
     playlist->items[playlist->count] = *item;
     playlist->count++;
     
+    // Cached sort orders no longer cover every item
+    playlist_sort_invalidate(playlist);
+    
     return true;
 }
 
+void playlist_set_favorite(Playlist* playlist, size_t index, bool favorite) {
+    if (!playlist || index >= playlist->count) return;
+    if (playlist->items[index].favorite == favorite) return;
+    
+    // The favorites order is keyed on this flag
+    playlist->items[index].favorite = favorite;
+    playlist_sort_invalidate(playlist);
+}
+
+void playlist_set_last_played(Playlist* playlist, size_t index, time_t when) {
+    if (!playlist || index >= playlist->count) return;
+    if (playlist->items[index].last_played == when) return;
+    
+    playlist->items[index].last_played = when;
+    playlist_sort_invalidate(playlist);
+}
+
 bool playlist_load_from_file(Playlist* playlist, const char* filename) {
     FILE* file = fopen(filename, "r");
     if (!file) return false;
@@ -2,6 +2,7 @@
 #define PLAYLIST_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <time.h>
 #include "ui_constants.h"
 
@@ -19,8 +20,12 @@ typedef struct {
     int duration;
     bool favorite;
     time_t last_played;
+    int age_rating;  // From tvg-rating, 0 if unrated
+    uint32_t group_id;  // Index into ui->categories, set by ui_update_categories
 } PlaylistItem;
 
+struct PlaylistSortIndex;
+
 // Playlist structure
 typedef struct {
     PlaylistItem* items;
@@ -28,6 +33,7 @@ typedef struct {
     size_t capacity;
     char* filename;
     time_t last_modified;
+    struct PlaylistSortIndex* sort_index;  // Cached sort orders, built on demand
 } Playlist;
 
 // Playlist functions
@@ -39,6 +45,8 @@ bool playlist_add_item(Playlist* playlist, const PlaylistItem* item);
 void playlist_remove_item(Playlist* playlist, size_t index);
 void playlist_clear(Playlist* playlist);
 void playlist_sort(Playlist* playlist);
+void playlist_set_favorite(Playlist* playlist, size_t index, bool favorite);
+void playlist_set_last_played(Playlist* playlist, size_t index, time_t when);
 
 // Item functions
 PlaylistItem* playlist_item_create(void);
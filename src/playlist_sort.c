@@ -0,0 +1,287 @@
+#include "playlist_sort.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+// Radix sort entry: fixed-width key plus the item it belongs to
+typedef struct {
+    uint64_t key;
+    uint32_t index;
+} SortEntry;
+
+// Tie-break context for runs of equal collation keys
+typedef struct {
+    const Playlist* playlist;
+    const uint32_t* title_rank;
+} CollateContext;
+
+static CollateContext collate_ctx;
+
+static uint64_t collation_key(const char* text);
+static void radix_sort(SortEntry* entries, SortEntry* scratch, size_t count);
+static void resolve_ties(SortEntry* entries, size_t count,
+                         int (*compare)(const void*, const void*));
+static int compare_title_entries(const void* a, const void* b);
+static int compare_group_entries(const void* a, const void* b);
+static void store_permutation(PlaylistSortIndex* index, PlaylistSortKey key,
+                              const SortEntry* entries);
+static void free_sort_index(PlaylistSortIndex* index);
+
+void playlist_sort(Playlist* playlist) {
+    playlist_sort_build(playlist);
+}
+
+bool playlist_sort_build(Playlist* playlist) {
+    if (!playlist) return false;
+
+    playlist_sort_invalidate(playlist);
+
+    size_t count = playlist->count;
+    PlaylistSortIndex* index = calloc(1, sizeof(PlaylistSortIndex));
+    SortEntry* entries = malloc((count + 1) * sizeof(SortEntry));
+    SortEntry* scratch = malloc((count + 1) * sizeof(SortEntry));
+    if (!index || !entries || !scratch) {
+        free(index);
+        free(entries);
+        free(scratch);
+        return false;
+    }
+
+    index->count = count;
+    for (int key = 0; key < PLAYLIST_SORT_KEY_COUNT; key++) {
+        index->order[key] = malloc((count + 1) * sizeof(uint32_t));
+        index->rank[key] = malloc((count + 1) * sizeof(uint32_t));
+        if (!index->order[key] || !index->rank[key]) {
+            free_sort_index(index);
+            free(entries);
+            free(scratch);
+            return false;
+        }
+    }
+
+    collate_ctx.playlist = playlist;
+
+    // Title: 8-byte case-folded prefix, full comparison only inside ties
+    for (size_t i = 0; i < count; i++) {
+        entries[i].key = collation_key(playlist->items[i].title);
+        entries[i].index = (uint32_t)i;
+    }
+    radix_sort(entries, scratch, count);
+    resolve_ties(entries, count, compare_title_entries);
+    store_permutation(index, PLAYLIST_SORT_TITLE, entries);
+
+    // The remaining orders are stable sorts on top of title order, so items
+    // with equal keys stay alphabetical without a secondary comparison
+    const uint32_t* title_order = index->order[PLAYLIST_SORT_TITLE];
+    collate_ctx.title_rank = index->rank[PLAYLIST_SORT_TITLE];
+
+    // Group
+    for (size_t i = 0; i < count; i++) {
+        uint32_t item = title_order[i];
+        entries[i].key = collation_key(playlist->items[item].group);
+        entries[i].index = item;
+    }
+    radix_sort(entries, scratch, count);
+    resolve_ties(entries, count, compare_group_entries);
+    store_permutation(index, PLAYLIST_SORT_GROUP, entries);
+
+    // Last played, most recent first
+    for (size_t i = 0; i < count; i++) {
+        uint32_t item = title_order[i];
+        entries[i].key = ~(uint64_t)playlist->items[item].last_played;
+        entries[i].index = item;
+    }
+    radix_sort(entries, scratch, count);
+    store_permutation(index, PLAYLIST_SORT_LAST_PLAYED, entries);
+
+    // Favorites first
+    for (size_t i = 0; i < count; i++) {
+        uint32_t item = title_order[i];
+        entries[i].key = playlist->items[item].favorite ? 0 : 1;
+        entries[i].index = item;
+    }
+    radix_sort(entries, scratch, count);
+    store_permutation(index, PLAYLIST_SORT_FAVORITES, entries);
+
+    collate_ctx.playlist = NULL;
+    collate_ctx.title_rank = NULL;
+
+    free(entries);
+    free(scratch);
+
+    playlist->sort_index = index;
+    return true;
+}
+
+void playlist_sort_invalidate(Playlist* playlist) {
+    if (!playlist || !playlist->sort_index) return;
+
+    free_sort_index(playlist->sort_index);
+    playlist->sort_index = NULL;
+}
+
+const uint32_t* playlist_sort_order(Playlist* playlist, PlaylistSortKey key) {
+    if (!playlist || key < 0 || key >= PLAYLIST_SORT_KEY_COUNT) return NULL;
+
+    if (!playlist->sort_index && !playlist_sort_build(playlist)) return NULL;
+    return playlist->sort_index->order[key];
+}
+
+const uint32_t* playlist_sort_rank(Playlist* playlist, PlaylistSortKey key) {
+    if (!playlist || key < 0 || key >= PLAYLIST_SORT_KEY_COUNT) return NULL;
+
+    if (!playlist->sort_index && !playlist_sort_build(playlist)) return NULL;
+    return playlist->sort_index->rank[key];
+}
+
+bool playlist_sort_indices(Playlist* playlist, PlaylistSortKey key,
+                           uint32_t* indices, size_t count) {
+    if (count < 2) return true;
+
+    const uint32_t* rank = playlist_sort_rank(playlist, key);
+    if (!rank) return false;
+
+    SortEntry* entries = malloc(count * sizeof(SortEntry));
+    SortEntry* scratch = malloc(count * sizeof(SortEntry));
+    if (!entries || !scratch) {
+        free(entries);
+        free(scratch);
+        return false;
+    }
+
+    // Ordering a subset is a linear pass over the global rank; no string
+    // comparisons happen here
+    for (size_t i = 0; i < count; i++) {
+        entries[i].key = rank[indices[i]];
+        entries[i].index = indices[i];
+    }
+    radix_sort(entries, scratch, count);
+
+    for (size_t i = 0; i < count; i++) {
+        indices[i] = entries[i].index;
+    }
+
+    free(entries);
+    free(scratch);
+    return true;
+}
+
+static uint64_t collation_key(const char* text) {
+    // Missing strings sort last
+    if (!text) return UINT64_MAX;
+
+    // Big-endian packing of the folded bytes keeps integer order equal to
+    // strcasecmp order for the first 8 characters
+    uint64_t key = 0;
+    int i = 0;
+    for (; i < 8 && text[i]; i++) {
+        key = (key << 8) | (uint8_t)tolower((unsigned char)text[i]);
+    }
+    for (; i < 8; i++) {
+        key <<= 8;
+    }
+    return key;
+}
+
+static void radix_sort(SortEntry* entries, SortEntry* scratch, size_t count) {
+    SortEntry* src = entries;
+    SortEntry* dst = scratch;
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t histogram[256] = {0};
+
+        for (size_t i = 0; i < count; i++) {
+            histogram[(src[i].key >> shift) & 0xFF]++;
+        }
+
+        // Skip passes where every key has the same byte
+        if (count == 0 || histogram[(src[0].key >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t n = histogram[b];
+            histogram[b] = offset;
+            offset += n;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            dst[histogram[(src[i].key >> shift) & 0xFF]++] = src[i];
+        }
+
+        SortEntry* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != entries) {
+        memcpy(entries, src, count * sizeof(SortEntry));
+    }
+}
+
+static void resolve_ties(SortEntry* entries, size_t count,
+                         int (*compare)(const void*, const void*)) {
+    // Only keys that share their whole 8-byte prefix need the full string
+    size_t start = 0;
+    while (start < count) {
+        size_t end = start + 1;
+        while (end < count && entries[end].key == entries[start].key) end++;
+
+        if (end - start > 1) {
+            qsort(&entries[start], end - start, sizeof(SortEntry), compare);
+        }
+        start = end;
+    }
+}
+
+static int compare_title_entries(const void* a, const void* b) {
+    const SortEntry* e1 = (const SortEntry*)a;
+    const SortEntry* e2 = (const SortEntry*)b;
+    const char* t1 = collate_ctx.playlist->items[e1->index].title;
+    const char* t2 = collate_ctx.playlist->items[e2->index].title;
+
+    if (t1 && t2) {
+        int cmp = strcasecmp(t1, t2);
+        if (cmp != 0) return cmp;
+    } else if (t1 != t2) {
+        return t1 ? -1 : 1;
+    }
+
+    return e1->index < e2->index ? -1 : e1->index > e2->index;
+}
+
+static int compare_group_entries(const void* a, const void* b) {
+    const SortEntry* e1 = (const SortEntry*)a;
+    const SortEntry* e2 = (const SortEntry*)b;
+    const char* g1 = collate_ctx.playlist->items[e1->index].group;
+    const char* g2 = collate_ctx.playlist->items[e2->index].group;
+
+    if (g1 && g2) {
+        int cmp = strcasecmp(g1, g2);
+        if (cmp != 0) return cmp;
+    } else if (g1 != g2) {
+        return g1 ? -1 : 1;
+    }
+
+    uint32_t r1 = collate_ctx.title_rank[e1->index];
+    uint32_t r2 = collate_ctx.title_rank[e2->index];
+    return r1 < r2 ? -1 : r1 > r2;
+}
+
+static void store_permutation(PlaylistSortIndex* index, PlaylistSortKey key,
+                              const SortEntry* entries) {
+    for (size_t pos = 0; pos < index->count; pos++) {
+        index->order[key][pos] = entries[pos].index;
+        index->rank[key][entries[pos].index] = (uint32_t)pos;
+    }
+}
+
+static void free_sort_index(PlaylistSortIndex* index) {
+    for (int key = 0; key < PLAYLIST_SORT_KEY_COUNT; key++) {
+        free(index->order[key]);
+        free(index->rank[key]);
+    }
+    free(index);
+}
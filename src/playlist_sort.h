@@ -0,0 +1,38 @@
+#ifndef PLAYLIST_SORT_H
+#define PLAYLIST_SORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "playlist.h"
+
+// Sort orders cached per playlist
+typedef enum {
+    PLAYLIST_SORT_TITLE,
+    PLAYLIST_SORT_GROUP,
+    PLAYLIST_SORT_LAST_PLAYED,
+    PLAYLIST_SORT_FAVORITES,
+    PLAYLIST_SORT_KEY_COUNT
+} PlaylistSortKey;
+
+// Cached sort permutations
+//
+// order[key][pos] is the item index at position pos, rank[key][item] is the
+// inverse. Both are built once with a radix sort on fixed-width collation
+// keys and reused until the playlist changes. Any code that edits items,
+// favorites or last_played must call playlist_sort_invalidate.
+typedef struct PlaylistSortIndex {
+    uint32_t* order[PLAYLIST_SORT_KEY_COUNT];
+    uint32_t* rank[PLAYLIST_SORT_KEY_COUNT];
+    size_t count;
+} PlaylistSortIndex;
+
+// Sort index functions
+bool playlist_sort_build(Playlist* playlist);
+void playlist_sort_invalidate(Playlist* playlist);
+const uint32_t* playlist_sort_order(Playlist* playlist, PlaylistSortKey key);
+const uint32_t* playlist_sort_rank(Playlist* playlist, PlaylistSortKey key);
+bool playlist_sort_indices(Playlist* playlist, PlaylistSortKey key,
+                           uint32_t* indices, size_t count);
+
+#endif // PLAYLIST_SORT_H
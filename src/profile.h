@@ -5,7 +5,7 @@
 #include "ui_constants.h"
 
 // Profile settings
-typedef struct {
+typedef struct Profile {
     char name[MAX_PROFILE_NAME];
     bool parental_controls_enabled;
     int age_rating;
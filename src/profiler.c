@@ -0,0 +1,196 @@
+#include "profiler.h"
+#include "drawing.h"
+#include "render_batch.h"
+#include "text_renderer.h"
+#include "texture_registry.h"
+#include "ui_constants.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define OVERLAY_X 20
+#define OVERLAY_Y 20
+#define OVERLAY_WIDTH (PROFILER_HISTORY * 2)
+#define GRAPH_HEIGHT 100
+#define GRAPH_SCALE_MS 33.3f   // Top of the graph, two 60 fps frames
+#define OVERLAY_LINE_LENGTH 96
+
+static const char* phase_names[PROFILER_PHASE_COUNT] = {
+    "frame",
+    "input",
+    "update",
+    "draw",
+    "draw_state",
+    "text",
+    "thumbnails",
+    "present"
+};
+
+static struct {
+    float samples[PROFILER_HISTORY][PROFILER_PHASE_COUNT];  // Milliseconds
+    float current[PROFILER_PHASE_COUNT];
+    int head;          // Next slot to write
+    int count;
+    Uint64 frame_start;
+    double ms_per_tick;
+    bool overlay;
+} profiler;
+
+static int compare_floats(const void* a, const void* b);
+
+void profiler_begin_frame(void) {
+    if (profiler.ms_per_tick == 0) {
+        profiler.ms_per_tick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    }
+
+    for (int p = 0; p < PROFILER_PHASE_COUNT; p++) {
+        profiler.current[p] = 0;
+    }
+    profiler.frame_start = SDL_GetPerformanceCounter();
+}
+
+void profiler_end_frame(bool keep) {
+    profiler_end(PROFILER_PHASE_FRAME, profiler.frame_start);
+
+    // Iterations that drew nothing would only dilute the percentiles
+    if (!keep) return;
+
+    for (int p = 0; p < PROFILER_PHASE_COUNT; p++) {
+        profiler.samples[profiler.head][p] = profiler.current[p];
+    }
+    profiler.head = (profiler.head + 1) % PROFILER_HISTORY;
+    if (profiler.count < PROFILER_HISTORY) profiler.count++;
+}
+
+Uint64 profiler_begin(void) {
+    return SDL_GetPerformanceCounter();
+}
+
+void profiler_end(ProfilerPhase phase, Uint64 start) {
+    // Phases entered several times a frame (text, thumbnails) accumulate
+    profiler.current[phase] += (float)((SDL_GetPerformanceCounter() - start) * profiler.ms_per_tick);
+}
+
+float profiler_percentile(ProfilerPhase phase, float percentile) {
+    if (profiler.count == 0) return 0;
+
+    float values[PROFILER_HISTORY];
+    for (int i = 0; i < profiler.count; i++) {
+        values[i] = profiler.samples[i][phase];
+    }
+    qsort(values, profiler.count, sizeof(float), compare_floats);
+
+    int index = (int)(percentile / 100.0f * (profiler.count - 1) + 0.5f);
+    return values[MAX(0, MIN(index, profiler.count - 1))];
+}
+
+void profiler_toggle_overlay(void) {
+    profiler.overlay = !profiler.overlay;
+}
+
+bool profiler_overlay_visible(void) {
+    return profiler.overlay;
+}
+
+void profiler_draw_overlay(SDL_Renderer* renderer, TTF_Font* font,
+                           const char* const* notes, int note_count) {
+    if (!profiler.overlay) return;
+
+    // Whatever was queued belongs under the overlay
+    render_batch_flush(renderer);
+
+    // Phase percentiles, then GPU memory against the texture budget
+    char lines[PROFILER_PHASE_COUNT + 1][OVERLAY_LINE_LENGTH];
+    for (int p = 0; p < PROFILER_PHASE_COUNT; p++) {
+        snprintf(lines[p], OVERLAY_LINE_LENGTH, "%-10s p50 %6.2f  p99 %6.2f ms", phase_names[p],
+                 profiler_percentile(p, 50), profiler_percentile(p, 99));
+    }
+    TextureRegistryStats textures;
+    texture_registry_get_stats(&textures);
+    snprintf(lines[PROFILER_PHASE_COUNT], OVERLAY_LINE_LENGTH,
+             "textures   %5.1f / %5.1f MB  peak %5.1f",
+             textures.bytes / 1048576.0, textures.budget / 1048576.0,
+             textures.peak / 1048576.0);
+
+    // The panel grows to the widest line, but stays on screen
+    int width = OVERLAY_WIDTH;
+    for (int i = 0; i <= PROFILER_PHASE_COUNT; i++) {
+        width = MAX(width, text_renderer_measure(renderer, font, lines[i]));
+    }
+    for (int i = 0; i < note_count; i++) {
+        width = MAX(width, text_renderer_measure(renderer, font, notes[i]));
+    }
+    width = MIN(width, WINDOW_WIDTH - 2 * OVERLAY_X);
+
+    int line_height = 24;
+    int height = GRAPH_HEIGHT + 20 + (PROFILER_PHASE_COUNT + 1 + note_count) * line_height;
+    SDL_Rect panel = {OVERLAY_X - 10, OVERLAY_Y - 10, width + 20, height};
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 192);
+    SDL_RenderFillRect(renderer, &panel);
+
+    // Frame time graph, oldest frame on the left, drawn in one call
+    SDL_Rect bars[PROFILER_HISTORY];
+    int graph_bottom = OVERLAY_Y + GRAPH_HEIGHT;
+    for (int i = 0; i < profiler.count; i++) {
+        int slot = (profiler.head - profiler.count + i + PROFILER_HISTORY) % PROFILER_HISTORY;
+        float ms = profiler.samples[slot][PROFILER_PHASE_FRAME];
+        int h = (int)(MIN(ms, GRAPH_SCALE_MS) / GRAPH_SCALE_MS * GRAPH_HEIGHT);
+        bars[i] = (SDL_Rect){OVERLAY_X + i * 2, graph_bottom - h, 2, MAX(h, 1)};
+    }
+    SDL_SetRenderDrawColor(renderer, 0x00, 0xA5, 0xE0, 0xFF);
+    SDL_RenderFillRects(renderer, bars, profiler.count);
+
+    // Frame budget line
+    int budget_y = graph_bottom - (int)(UI_FRAME_BUDGET_MS / GRAPH_SCALE_MS * GRAPH_HEIGHT);
+    SDL_SetRenderDrawColor(renderer, 0xFF, 0x40, 0x40, 0xFF);
+    SDL_RenderDrawLine(renderer, OVERLAY_X, budget_y, OVERLAY_X + OVERLAY_WIDTH, budget_y);
+
+    SDL_Color white = {255, 255, 255, 255};
+    int y = graph_bottom + 10;
+    for (int i = 0; i <= PROFILER_PHASE_COUNT; i++) {
+        draw_text(renderer, font, lines[i], OVERLAY_X, y, white, false);
+        y += line_height;
+    }
+    for (int i = 0; i < note_count; i++) {
+        draw_text(renderer, font, notes[i], OVERLAY_X, y, white, false);
+        y += line_height;
+    }
+}
+
+bool profiler_dump(const char* filename) {
+    FILE* file = fopen(filename, "w");
+    if (!file) return false;
+
+    fprintf(file, "frame");
+    for (int p = 0; p < PROFILER_PHASE_COUNT; p++) {
+        fprintf(file, ",%s_ms", phase_names[p]);
+    }
+    fprintf(file, "\n");
+
+    // Oldest frame first
+    for (int i = 0; i < profiler.count; i++) {
+        int slot = (profiler.head - profiler.count + i + PROFILER_HISTORY) % PROFILER_HISTORY;
+        fprintf(file, "%d", i);
+        for (int p = 0; p < PROFILER_PHASE_COUNT; p++) {
+            fprintf(file, ",%.3f", profiler.samples[slot][p]);
+        }
+        fprintf(file, "\n");
+    }
+
+    for (int q = 0; q < 2; q++) {
+        float percentile = q == 0 ? 50 : 99;
+        fprintf(file, "p%d", (int)percentile);
+        for (int p = 0; p < PROFILER_PHASE_COUNT; p++) {
+            fprintf(file, ",%.3f", profiler_percentile(p, percentile));
+        }
+        fprintf(file, "\n");
+    }
+
+    return fclose(file) == 0;
+}
+
+static int compare_floats(const void* a, const void* b) {
+    float fa = *(const float*)a;
+    float fb = *(const float*)b;
+    return fa < fb ? -1 : fa > fb;
+}
@@ -0,0 +1,47 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <stdbool.h>
+
+#define PROFILER_HISTORY 240  // Frames kept, about 4 seconds at 60 fps
+#define PROFILER_DUMP_FILE "frame_profile.csv"
+
+// Timed phases of a frame
+typedef enum {
+    PROFILER_PHASE_FRAME,       // Whole loop iteration, without idle waiting
+    PROFILER_PHASE_INPUT,
+    PROFILER_PHASE_UPDATE,
+    PROFILER_PHASE_DRAW,
+    PROFILER_PHASE_DRAW_STATE,  // State-specific draw function
+    PROFILER_PHASE_TEXT,
+    PROFILER_PHASE_THUMBNAILS,
+    PROFILER_PHASE_PRESENT,
+    PROFILER_PHASE_COUNT
+} ProfilerPhase;
+
+// Frame profiler
+//
+// Phases are timed with the performance counter and summed per frame into a
+// fixed ring of the last PROFILER_HISTORY frames. Timing a phase is two
+// counter reads, so the timers stay in release builds:
+//
+//     Uint64 start = profiler_begin();
+//     ...
+//     profiler_end(PROFILER_PHASE_TEXT, start);
+//
+// The overlay lists the phases and texture memory, then any notes the
+// caller passes for subsystems the profiler does not know about.
+void profiler_begin_frame(void);
+void profiler_end_frame(bool keep);
+Uint64 profiler_begin(void);
+void profiler_end(ProfilerPhase phase, Uint64 start);
+float profiler_percentile(ProfilerPhase phase, float percentile);
+void profiler_toggle_overlay(void);
+bool profiler_overlay_visible(void);
+void profiler_draw_overlay(SDL_Renderer* renderer, TTF_Font* font,
+                           const char* const* notes, int note_count);
+bool profiler_dump(const char* filename);
+
+#endif // PROFILER_H
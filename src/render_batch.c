@@ -0,0 +1,191 @@
+#include "render_batch.h"
+#include "text_renderer.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BATCH_INITIAL_QUADS 128
+
+// Queued quad; texture is NULL for solid rects
+typedef struct {
+    SDL_Texture* texture;
+    int order;              // Submission order, keeps sorting stable
+    SDL_Vertex vertices[4];
+} BatchQuad;
+
+typedef struct {
+    BatchQuad* quads;
+    int count;
+    int capacity;
+} BatchLayer;
+
+static struct {
+    SDL_Renderer* renderer;
+    BatchLayer layers[RENDER_LAYER_COUNT];
+    int queued;
+
+    // Scratch buffers for submission
+    SDL_Vertex* vertices;
+    int* indices;
+    int scratch_capacity;
+} batch;
+
+static BatchQuad* push_quad(SDL_Renderer* renderer, RenderLayer layer);
+static void set_quad(BatchQuad* quad, const SDL_Rect* dst, SDL_Color color,
+                     float u0, float v0, float u1, float v1);
+static bool reserve_scratch(int quads);
+static void submit(SDL_Renderer* renderer, SDL_Texture* texture, const BatchQuad* quads, int count);
+static int compare_quads(const void* a, const void* b);
+
+void render_batch_rect(SDL_Renderer* renderer, RenderLayer layer,
+                       const SDL_Rect* rect, SDL_Color color) {
+    BatchQuad* quad = push_quad(renderer, layer);
+    if (!quad) return;
+
+    quad->texture = NULL;
+    set_quad(quad, rect, color, 0, 0, 0, 0);
+}
+
+void render_batch_texture(SDL_Renderer* renderer, RenderLayer layer, SDL_Texture* texture,
+                          const SDL_Rect* src, const SDL_Rect* dst) {
+    if (!texture) return;
+
+    float u0 = 0, v0 = 0, u1 = 1, v1 = 1;
+    if (src) {
+        int w, h;
+        if (SDL_QueryTexture(texture, NULL, NULL, &w, &h) != 0 || w <= 0 || h <= 0) return;
+
+        u0 = (float)src->x / w;
+        v0 = (float)src->y / h;
+        u1 = (float)(src->x + src->w) / w;
+        v1 = (float)(src->y + src->h) / h;
+    }
+
+    BatchQuad* quad = push_quad(renderer, layer);
+    if (!quad) return;
+
+    SDL_Color white = {255, 255, 255, 255};
+    quad->texture = texture;
+    set_quad(quad, dst, white, u0, v0, u1, v1);
+}
+
+void render_batch_flush(SDL_Renderer* renderer) {
+    if (batch.queued > 0 && (!renderer || batch.renderer == renderer)) {
+        SDL_SetRenderDrawBlendMode(batch.renderer, SDL_BLENDMODE_BLEND);
+
+        for (int l = 0; l < RENDER_LAYER_COUNT; l++) {
+            BatchLayer* layer = &batch.layers[l];
+            if (layer->count == 0) continue;
+
+            // Group by texture; solid rects (NULL) come first
+            qsort(layer->quads, layer->count, sizeof(BatchQuad), compare_quads);
+
+            int start = 0;
+            while (start < layer->count) {
+                int end = start + 1;
+                while (end < layer->count && layer->quads[end].texture == layer->quads[start].texture) {
+                    end++;
+                }
+                submit(batch.renderer, layer->quads[start].texture, &layer->quads[start], end - start);
+                start = end;
+            }
+            layer->count = 0;
+        }
+        batch.queued = 0;
+    }
+
+    // Text sits above every batched layer
+    text_renderer_flush(renderer);
+}
+
+void render_batch_shutdown(void) {
+    for (int l = 0; l < RENDER_LAYER_COUNT; l++) {
+        free(batch.layers[l].quads);
+    }
+    free(batch.vertices);
+    free(batch.indices);
+    memset(&batch, 0, sizeof(batch));
+}
+
+static BatchQuad* push_quad(SDL_Renderer* renderer, RenderLayer layer) {
+    if (layer < 0 || layer >= RENDER_LAYER_COUNT) return NULL;
+
+    // Queued work belongs to one renderer at a time
+    if (batch.queued > 0 && batch.renderer != renderer) {
+        render_batch_flush(batch.renderer);
+    }
+    batch.renderer = renderer;
+
+    BatchLayer* l = &batch.layers[layer];
+    if (l->count == l->capacity) {
+        int capacity = l->capacity ? l->capacity * 2 : BATCH_INITIAL_QUADS;
+        BatchQuad* quads = realloc(l->quads, capacity * sizeof(BatchQuad));
+        if (!quads) return NULL;
+
+        l->quads = quads;
+        l->capacity = capacity;
+    }
+
+    BatchQuad* quad = &l->quads[l->count++];
+    quad->order = batch.queued++;
+    return quad;
+}
+
+static void set_quad(BatchQuad* quad, const SDL_Rect* dst, SDL_Color color,
+                     float u0, float v0, float u1, float v1) {
+    float x0 = (float)dst->x;
+    float y0 = (float)dst->y;
+    float x1 = (float)(dst->x + dst->w);
+    float y1 = (float)(dst->y + dst->h);
+
+    quad->vertices[0] = (SDL_Vertex){{x0, y0}, color, {u0, v0}};
+    quad->vertices[1] = (SDL_Vertex){{x1, y0}, color, {u1, v0}};
+    quad->vertices[2] = (SDL_Vertex){{x1, y1}, color, {u1, v1}};
+    quad->vertices[3] = (SDL_Vertex){{x0, y1}, color, {u0, v1}};
+}
+
+static bool reserve_scratch(int quads) {
+    if (quads <= batch.scratch_capacity) return true;
+
+    int capacity = batch.scratch_capacity ? batch.scratch_capacity : BATCH_INITIAL_QUADS;
+    while (capacity < quads) capacity *= 2;
+
+    SDL_Vertex* vertices = realloc(batch.vertices, capacity * 4 * sizeof(SDL_Vertex));
+    if (vertices) batch.vertices = vertices;
+    int* indices = realloc(batch.indices, capacity * 6 * sizeof(int));
+    if (indices) batch.indices = indices;
+    if (!vertices || !indices) return false;
+
+    // Index pattern is fixed per quad, so only new quads need filling
+    for (int q = batch.scratch_capacity; q < capacity; q++) {
+        int* idx = &batch.indices[q * 6];
+        idx[0] = q * 4;
+        idx[1] = q * 4 + 1;
+        idx[2] = q * 4 + 2;
+        idx[3] = q * 4;
+        idx[4] = q * 4 + 2;
+        idx[5] = q * 4 + 3;
+    }
+    batch.scratch_capacity = capacity;
+    return true;
+}
+
+static void submit(SDL_Renderer* renderer, SDL_Texture* texture, const BatchQuad* quads, int count) {
+    if (!reserve_scratch(count)) return;
+
+    for (int q = 0; q < count; q++) {
+        memcpy(&batch.vertices[q * 4], quads[q].vertices, sizeof(quads[q].vertices));
+    }
+
+    SDL_RenderGeometry(renderer, texture, batch.vertices, count * 4, batch.indices, count * 6);
+}
+
+static int compare_quads(const void* a, const void* b) {
+    const BatchQuad* q1 = (const BatchQuad*)a;
+    const BatchQuad* q2 = (const BatchQuad*)b;
+
+    if (q1->texture != q2->texture) {
+        return (uintptr_t)q1->texture < (uintptr_t)q2->texture ? -1 : 1;
+    }
+    return q1->order - q2->order;
+}
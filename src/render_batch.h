@@ -0,0 +1,30 @@
+#ifndef RENDER_BATCH_H
+#define RENDER_BATCH_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// Draw order of batched primitives; text from the text renderer goes last
+typedef enum {
+    RENDER_LAYER_BACKGROUND,    // Highlights, placeholders, cell fills
+    RENDER_LAYER_CONTENT,       // Thumbnails and logos
+    RENDER_LAYER_OVERLAY,       // Fills drawn over content, such as title bars
+    RENDER_LAYER_COUNT
+} RenderLayer;
+
+// Render batch
+//
+// Solid rects and textured quads are queued per layer and submitted with
+// SDL_RenderGeometry at flush: one call for all solid rects of a layer and
+// one per distinct texture. Order is only kept between layers, so
+// primitives within a layer must not overlap. render_batch_flush also
+// flushes queued text, and must run before anything drawn directly that
+// has to appear on top.
+void render_batch_rect(SDL_Renderer* renderer, RenderLayer layer,
+                       const SDL_Rect* rect, SDL_Color color);
+void render_batch_texture(SDL_Renderer* renderer, RenderLayer layer, SDL_Texture* texture,
+                          const SDL_Rect* src, const SDL_Rect* dst);
+void render_batch_flush(SDL_Renderer* renderer);
+void render_batch_shutdown(void);
+
+#endif // RENDER_BATCH_H
@@ -0,0 +1,174 @@
+#include "result_set.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define RESULT_SET_MIN_CAPACITY 256
+
+static void mask_tail(ItemBitmap* bitmap);
+
+void result_set_init(ResultSet* set) {
+    set->indices = NULL;
+    set->count = 0;
+    set->capacity = 0;
+}
+
+void result_set_free(ResultSet* set) {
+    if (!set) return;
+
+    free(set->indices);
+    result_set_init(set);
+}
+
+void result_set_clear(ResultSet* set) {
+    if (set) set->count = 0;
+}
+
+bool result_set_reserve(ResultSet* set, size_t capacity) {
+    if (capacity <= set->capacity) return true;
+
+    size_t new_capacity = set->capacity == 0 ? RESULT_SET_MIN_CAPACITY : set->capacity;
+    while (new_capacity < capacity) new_capacity *= 2;
+
+    uint32_t* new_indices = realloc(set->indices, new_capacity * sizeof(uint32_t));
+    if (!new_indices) return false;
+
+    set->indices = new_indices;
+    set->capacity = new_capacity;
+    return true;
+}
+
+bool result_set_push(ResultSet* set, uint32_t index) {
+    if (!result_set_reserve(set, set->count + 1)) return false;
+
+    set->indices[set->count++] = index;
+    return true;
+}
+
+bool result_set_append(ResultSet* set, const uint32_t* indices, size_t count) {
+    if (count == 0) return true;
+    if (!result_set_reserve(set, set->count + count)) return false;
+
+    memcpy(&set->indices[set->count], indices, count * sizeof(uint32_t));
+    set->count += count;
+    return true;
+}
+
+bool result_set_from_bitmap(ResultSet* set, const ItemBitmap* bitmap) {
+    result_set_clear(set);
+    if (!result_set_reserve(set, item_bitmap_count(bitmap))) return false;
+
+    size_t words = ITEM_BITMAP_WORDS(bitmap->bit_count);
+    for (size_t w = 0; w < words; w++) {
+        uint64_t bits = bitmap->words[w];
+        while (bits) {
+            set->indices[set->count++] = (uint32_t)(w * 64 + __builtin_ctzll(bits));
+            bits &= bits - 1;
+        }
+    }
+
+    return true;
+}
+
+bool result_set_to_bitmap(const ResultSet* set, ItemBitmap* bitmap) {
+    item_bitmap_clear_all(bitmap);
+
+    for (size_t i = 0; i < set->count; i++) {
+        if (set->indices[i] >= bitmap->bit_count) return false;
+        item_bitmap_set(bitmap, set->indices[i]);
+    }
+
+    return true;
+}
+
+bool item_bitmap_init(ItemBitmap* bitmap, size_t bit_count) {
+    bitmap->bit_count = bit_count;
+    bitmap->words = calloc(ITEM_BITMAP_WORDS(bit_count) + 1, sizeof(uint64_t));
+    return bitmap->words != NULL;
+}
+
+void item_bitmap_free(ItemBitmap* bitmap) {
+    if (!bitmap) return;
+
+    free(bitmap->words);
+    bitmap->words = NULL;
+    bitmap->bit_count = 0;
+}
+
+bool item_bitmap_resize(ItemBitmap* bitmap, size_t bit_count) {
+    size_t old_words = ITEM_BITMAP_WORDS(bitmap->bit_count);
+    size_t new_words = ITEM_BITMAP_WORDS(bit_count);
+
+    if (new_words != old_words || !bitmap->words) {
+        uint64_t* words = realloc(bitmap->words, (new_words + 1) * sizeof(uint64_t));
+        if (!words) return false;
+
+        if (new_words > old_words) {
+            memset(&words[old_words], 0, (new_words + 1 - old_words) * sizeof(uint64_t));
+        }
+        bitmap->words = words;
+    }
+
+    bitmap->bit_count = bit_count;
+    mask_tail(bitmap);
+    return true;
+}
+
+void item_bitmap_clear_all(ItemBitmap* bitmap) {
+    memset(bitmap->words, 0, ITEM_BITMAP_WORDS(bitmap->bit_count) * sizeof(uint64_t));
+}
+
+void item_bitmap_set_all(ItemBitmap* bitmap) {
+    size_t words = ITEM_BITMAP_WORDS(bitmap->bit_count);
+    if (words == 0) return;
+
+    memset(bitmap->words, 0xFF, words * sizeof(uint64_t));
+    mask_tail(bitmap);
+}
+
+size_t item_bitmap_count(const ItemBitmap* bitmap) {
+    size_t count = 0;
+    size_t words = ITEM_BITMAP_WORDS(bitmap->bit_count);
+
+    for (size_t w = 0; w < words; w++) {
+        count += (size_t)__builtin_popcountll(bitmap->words[w]);
+    }
+    return count;
+}
+
+void item_bitmap_and(ItemBitmap* dst, const ItemBitmap* src) {
+    size_t words = ITEM_BITMAP_WORDS(dst->bit_count < src->bit_count ? dst->bit_count
+                                                                      : src->bit_count);
+    for (size_t w = 0; w < words; w++) {
+        dst->words[w] &= src->words[w];
+    }
+
+    // Items the source does not cover are not in the intersection
+    size_t dst_words = ITEM_BITMAP_WORDS(dst->bit_count);
+    if (dst_words > words) {
+        memset(&dst->words[words], 0, (dst_words - words) * sizeof(uint64_t));
+    }
+}
+
+void item_bitmap_or(ItemBitmap* dst, const ItemBitmap* src) {
+    size_t words = ITEM_BITMAP_WORDS(dst->bit_count < src->bit_count ? dst->bit_count
+                                                                      : src->bit_count);
+    for (size_t w = 0; w < words; w++) {
+        dst->words[w] |= src->words[w];
+    }
+    mask_tail(dst);
+}
+
+void item_bitmap_andnot(ItemBitmap* dst, const ItemBitmap* src) {
+    size_t words = ITEM_BITMAP_WORDS(dst->bit_count < src->bit_count ? dst->bit_count
+                                                                      : src->bit_count);
+    for (size_t w = 0; w < words; w++) {
+        dst->words[w] &= ~src->words[w];
+    }
+}
+
+static void mask_tail(ItemBitmap* bitmap) {
+    // Bits past the last item are kept clear so counts and iteration stay exact
+    if (bitmap->bit_count & 63) {
+        bitmap->words[bitmap->bit_count >> 6] &= ((uint64_t)1 << (bitmap->bit_count & 63)) - 1;
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef RESULT_SET_H
+#define RESULT_SET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// List of playlist item indices
+//
+// Indices stay valid when playlist->items is reallocated and take half the
+// space of PlaylistItem pointers. The buffer is kept between searches, so
+// clearing a set does not free it.
+typedef struct {
+    uint32_t* indices;
+    size_t count;
+    size_t capacity;
+} ResultSet;
+
+// Bitmap over playlist item indices, one bit per item
+typedef struct {
+    uint64_t* words;
+    size_t bit_count;
+} ItemBitmap;
+
+#define ITEM_BITMAP_WORDS(bits) (((bits) + 63) / 64)
+
+// Result set functions
+void result_set_init(ResultSet* set);
+void result_set_free(ResultSet* set);
+void result_set_clear(ResultSet* set);
+bool result_set_reserve(ResultSet* set, size_t capacity);
+bool result_set_push(ResultSet* set, uint32_t index);
+bool result_set_append(ResultSet* set, const uint32_t* indices, size_t count);
+bool result_set_from_bitmap(ResultSet* set, const ItemBitmap* bitmap);
+bool result_set_to_bitmap(const ResultSet* set, ItemBitmap* bitmap);
+
+// Bitmap functions
+bool item_bitmap_init(ItemBitmap* bitmap, size_t bit_count);
+void item_bitmap_free(ItemBitmap* bitmap);
+bool item_bitmap_resize(ItemBitmap* bitmap, size_t bit_count);
+void item_bitmap_clear_all(ItemBitmap* bitmap);
+void item_bitmap_set_all(ItemBitmap* bitmap);
+size_t item_bitmap_count(const ItemBitmap* bitmap);
+void item_bitmap_and(ItemBitmap* dst, const ItemBitmap* src);
+void item_bitmap_or(ItemBitmap* dst, const ItemBitmap* src);
+void item_bitmap_andnot(ItemBitmap* dst, const ItemBitmap* src);
+
+static inline void item_bitmap_set(ItemBitmap* bitmap, uint32_t index) {
+    bitmap->words[index >> 6] |= (uint64_t)1 << (index & 63);
+}
+
+static inline void item_bitmap_reset(ItemBitmap* bitmap, uint32_t index) {
+    bitmap->words[index >> 6] &= ~((uint64_t)1 << (index & 63));
+}
+
+static inline bool item_bitmap_test(const ItemBitmap* bitmap, uint32_t index) {
+    return (bitmap->words[index >> 6] >> (index & 63)) & 1;
+}
+
+#endif // RESULT_SET_H
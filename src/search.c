@@ -1,20 +1,29 @@
 #include "search.h"
+#include "search_worker.h"
+#include "filter_engine.h"
 #include "ui_constants.h"
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 
+// Playlist the fallback comparator resolves indices against
+static const Playlist* sort_playlist;
+
+static int compare_items_by_title(const void* a, const void* b);
+static const ItemBitmap* search_apply_filters(UI* ui);
+
 void search_init(SearchContext* ctx) {
     memset(ctx->query, 0, sizeof(ctx->query));
     ctx->show_favorites_only = false;
-    ctx->results = NULL;
-    ctx->result_count = 0;
+    result_set_init(&ctx->results);
+    memset(&ctx->filter, 0, sizeof(ctx->filter));
     ctx->selected_category = NULL;
+    ctx->sort_key = PLAYLIST_SORT_TITLE;
 }
 
 void search_clear(SearchContext* ctx) {
-    free(ctx->results);
-    ctx->results = NULL;
-    ctx->result_count = 0;
+    // Keep the buffer; the next search reuses it
+    result_set_clear(&ctx->results);
 }
 
 bool search_matches_item(const SearchContext* ctx, const PlaylistItem* item) {
@@ -27,6 +36,12 @@ bool search_matches_item(const SearchContext* ctx, const PlaylistItem* item) {
         return false;
     }
     
+    return search_matches_query(ctx, item);
+}
+
+bool search_matches_query(const SearchContext* ctx, const PlaylistItem* item) {
+    if (!item || !item->title) return false;
+    
     // Empty query matches everything
     if (!ctx->query[0]) return true;
     
@@ -46,8 +61,60 @@ bool search_matches_item(const SearchContext* ctx, const PlaylistItem* item) {
 }
 
 void search_update(UI* ui, const char* query) {
-    strncpy(ui->search.query, query, sizeof(ui->search.query) - 1);
-    search_filter_results(ui);
+    // Searching again for the current query passes the buffer itself
+    if (query != ui->search.query) {
+        strncpy(ui->search.query, query, sizeof(ui->search.query) - 1);
+    }
+    search_clear(&ui->search);
+    
+    // Start the worker on first use
+    if (!ui->search_worker) {
+        ui->search_worker = search_worker_create();
+    }
+    
+    // Fall back to searching inline if no worker thread is available
+    if (!ui->search_worker) {
+        ui->search_pending = false;
+        search_filter_results(ui);
+        return;
+    }
+    
+    ui->search_generation = search_worker_submit(ui->search_worker,
+                                                 ui->playlist, &ui->search,
+                                                 search_apply_filters(ui));
+    ui->search_pending = true;
+}
+
+void ui_perform_search(UI* ui) {
+    if (!ui) return;
+    search_update(ui, ui->keyboard.text ? ui->keyboard.text : ui->search.query);
+}
+
+void search_poll_results(UI* ui) {
+    if (!ui->search_pending || !ui->search_worker) return;
+    
+    bool done = false;
+    if (!search_worker_poll(ui->search_worker, ui->search_generation,
+                            &ui->search, &done)) {
+        return;
+    }
+    
+    ui_invalidate(ui, UI_DIRTY_CONTENT);
+    
+    if (done) {
+        ui->search_pending = false;
+        search_sort_results(ui);
+    }
+}
+
+void search_shutdown(UI* ui) {
+    if (!ui) return;
+    
+    search_worker_free(ui->search_worker);
+    ui->search_worker = NULL;
+    ui->search_pending = false;
+    result_set_free(&ui->search.results);
+    item_bitmap_free(&ui->search.filter);
 }
 
 void search_filter_results(UI* ui) {
@@ -55,49 +122,61 @@ void search_filter_results(UI* ui) {
     
     if (!ui->playlist) return;
     
-    // Count matching items first
-    size_t count = 0;
+    const ItemBitmap* visible = search_apply_filters(ui);
+    
     for (size_t i = 0; i < ui->playlist->count; i++) {
-        if (search_matches_item(&ui->search, &ui->playlist->items[i])) {
-            count++;
-        }
+        const PlaylistItem* item = &ui->playlist->items[i];
+        bool matches = visible
+            ? item_bitmap_test(visible, (uint32_t)i) && search_matches_query(&ui->search, item)
+            : search_matches_item(&ui->search, item);
+        
+        if (matches && !result_set_push(&ui->search.results, (uint32_t)i)) break;
     }
     
-    if (count == 0) return;
+    search_sort_results(ui);
+}
+
+static const ItemBitmap* search_apply_filters(UI* ui) {
+    FilterEngine* engine = ui->filter_engine;
+    if (!engine || !ui->playlist || engine->item_count != ui->playlist->count) {
+        return NULL;
+    }
     
-    // Allocate results array
-    ui->search.results = malloc(count * sizeof(PlaylistItem*));
+    // Favorites, category, blocked and age checks all come from the engine's
+    // bitmaps, combined here so the views keep their own selection
+    int category = ui_find_category(ui, ui->search.selected_category);
+    if (ui->search.selected_category && category < 0) return NULL;
     
-    // Fill results array
-    size_t j = 0;
-    for (size_t i = 0; i < ui->playlist->count; i++) {
-        if (search_matches_item(&ui->search, &ui->playlist->items[i])) {
-            ui->search.results[j++] = &ui->playlist->items[i];
-        }
+    if (!filter_engine_combine(engine, category < 0 ? FILTER_NO_CATEGORY : (uint32_t)category,
+                               ui->search.show_favorites_only, &ui->search.filter)) {
+        return NULL;
     }
-    
-    ui->search.result_count = count;
-    search_sort_results(ui);
+    return &ui->search.filter;
 }
 
 void search_sort_results(UI* ui) {
-    // Sort by title (case insensitive)
-    if (ui->search.result_count > 1) {
-        qsort(ui->search.results, ui->search.result_count, 
-              sizeof(PlaylistItem*), compare_items_by_title);
+    if (ui->search.results.count < 2) return;
+    
+    // Order by the playlist's cached rank; no string comparisons per search
+    if (playlist_sort_indices(ui->playlist, ui->search.sort_key,
+                              ui->search.results.indices,
+                              ui->search.results.count)) {
+        return;
     }
+    
+    // Sort by title (case insensitive) if the sort index is unavailable
+    sort_playlist = ui->playlist;
+    qsort(ui->search.results.indices, ui->search.results.count, 
+          sizeof(uint32_t), compare_items_by_title);
+    sort_playlist = NULL;
 }
 
-int compare_items_by_title(const void* a, const void* b) {
-    const PlaylistItem* item1 = *(const PlaylistItem**)a;
-    const PlaylistItem* item2 = *(const PlaylistItem**)b;
+static int compare_items_by_title(const void* a, const void* b) {
+    const PlaylistItem* item1 = &sort_playlist->items[*(const uint32_t*)a];
+    const PlaylistItem* item2 = &sort_playlist->items[*(const uint32_t*)b];
     
     if (!item1->title) return 1;
     if (!item2->title) return -1;
     
     return strcasecmp(item1->title, item2->title);
 }
-
-void search_history_update_suggestions(UI* ui) {
-    // הוסף כאן את הלוגיקה לעדכון הצעות החיפוש
-} 
\ No newline at end of file
@@ -1,18 +1,39 @@
 #include "ui.h"
 #include "ui_constants.h"
+#include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <stdlib.h>
+#include <math.h>
+#include <sys/stat.h>
+
+#define SEARCH_HISTORY_FILE APP_DATA_DIR "/search_history.log"
+#define SEARCH_HISTORY_HALF_LIFE (7.0 * 24 * 3600)  // Use count halves every week
+
+static bool search_history_load(SearchHistory* history);
+static void search_history_apply(SearchHistory* history, const char* query,
+                                 time_t when, double weight);
+static void search_history_append_record(SearchHistory* history, const char* query,
+                                         time_t when, double weight);
+static void search_history_compact(SearchHistory* history);
+static double entry_rank(double score, time_t last_used);
 
 SearchHistory* search_history_create(void) {
     SearchHistory* history = malloc(sizeof(SearchHistory));
     if (!history) return NULL;
     
-    history->items = calloc(MAX_SEARCH_HISTORY, sizeof(char*));
+    history->entries = calloc(MAX_SEARCH_HISTORY, sizeof(SearchHistoryEntry));
     history->count = 0;
     history->capacity = MAX_SEARCH_HISTORY;
     history->input_buffer = calloc(MAX_INPUT_LENGTH, sizeof(char));
     history->suggestions = calloc(MAX_SUGGESTIONS, sizeof(char*));
     history->suggestion_count = 0;
+
+    // The log is read on first use, not at startup
+    mkdir(APP_DATA_DIR, 0755);
+    history->path = strdup(SEARCH_HISTORY_FILE);
+    history->loaded = false;
+    history->log_records = 0;
     
     return history;
 }
@@ -21,9 +42,9 @@ void search_history_free(SearchHistory* history) {
     if (!history) return;
     
     for (size_t i = 0; i < history->count; i++) {
-        free(history->items[i]);
+        free(history->entries[i].query);
     }
-    free(history->items);
+    free(history->entries);
     
     free(history->input_buffer);
     
@@ -32,43 +53,53 @@ void search_history_free(SearchHistory* history) {
     }
     free(history->suggestions);
     
+    free(history->path);
     free(history);
 }
 
 void search_history_add(SearchHistory* history, const char* query) {
     if (!history || !query || !query[0]) return;
     
-    // Check if query already exists
+    // Records are line based
+    if (strchr(query, '\n') || strchr(query, '\r')) return;
+
+    search_history_load(history);
+
+    time_t now = time(NULL);
+    search_history_apply(history, query, now, 1.0);
+    search_history_append_record(history, query, now, 1.0);
+
+    // Rewrite the log once it holds mostly superseded records
+    if (history->log_records > history->count * 4 + 32) {
+        search_history_compact(history);
+    }
+}
+
+void search_history_clear(SearchHistory* history) {
+    if (!history) return;
+
     for (size_t i = 0; i < history->count; i++) {
-        if (strcmp(history->items[i], query) == 0) {
-            // Move to front
-            char* temp = history->items[i];
-            memmove(&history->items[1], &history->items[0], i * sizeof(char*));
-            history->items[0] = temp;
-            return;
-        }
+        free(history->entries[i].query);
     }
+    history->count = 0;
     
-    // Add new query
-    char* new_query = strdup(query);
-    if (!new_query) return;
-    
-    if (history->count >= history->capacity) {
-        free(history->items[history->capacity - 1]);
-        memmove(&history->items[1], &history->items[0], 
-                (history->capacity - 1) * sizeof(char*));
-    } else {
-        memmove(&history->items[1], &history->items[0], 
-                history->count * sizeof(char*));
-        history->count++;
+    for (size_t i = 0; i < history->suggestion_count; i++) {
+        free(history->suggestions[i]);
     }
+    history->suggestion_count = 0;
     
-    history->items[0] = new_query;
+    // Truncate the log; nothing left to load
+    FILE* file = fopen(history->path, "w");
+    if (file) fclose(file);
+    history->log_records = 0;
+    history->loaded = true;
 }
 
 void search_history_update_suggestions(UI* ui) {
     SearchHistory* history = ui->keyboard.history;
     const char* input = ui->keyboard.text;
+
+    if (!history) return;
     
     // Clear old suggestions
     for (size_t i = 0; i < history->suggestion_count; i++) {
@@ -76,14 +107,21 @@ void search_history_update_suggestions(UI* ui) {
     }
     history->suggestion_count = 0;
     
+    // The keyboard shows the history's list; a new list drops the selection
+    ui->keyboard.suggestions = history->suggestions;
+    ui->keyboard.suggestion_count = 0;
+    ui->keyboard.selected_suggestion = -1;
+    
     if (!input || !input[0]) return;
     
-    // Find matching items from history
+    search_history_load(history);
+
+    // Entries are kept in rank order, so the first matches are the best ones
     size_t input_len = strlen(input);
     for (size_t i = 0; i < history->count; i++) {
-        if (strncasecmp(history->items[i], input, input_len) == 0) {
+        if (strncasecmp(history->entries[i].query, input, input_len) == 0) {
             history->suggestions[history->suggestion_count++] = 
-                strdup(history->items[i]);
+                strdup(history->entries[i].query);
             
             if (history->suggestion_count >= MAX_SUGGESTIONS) break;
         }
@@ -102,4 +140,132 @@ void search_history_update_suggestions(UI* ui) {
             }
         }
     }
-} 
\ No newline at end of file
+    
+    ui->keyboard.suggestion_count = history->suggestion_count;
+} 
+
+static bool search_history_load(SearchHistory* history) {
+    if (history->loaded) return true;
+    history->loaded = true;
+
+    FILE* file = fopen(history->path, "r");
+    if (!file) return false;
+
+    // Each record is "<time> <weight> <query>"; replaying them in order
+    // rebuilds the decayed scores
+    char line[MAX_QUERY_LENGTH + 64];
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+
+        long long when;
+        double weight;
+        int offset = 0;
+        if (sscanf(line, "%lld %lf %n", &when, &weight, &offset) != 2 || !line[offset]) {
+            continue;
+        }
+
+        search_history_apply(history, line + offset, (time_t)when, weight);
+        history->log_records++;
+    }
+
+    fclose(file);
+    return true;
+}
+
+static void search_history_apply(SearchHistory* history, const char* query,
+                                 time_t when, double weight) {
+    size_t pos = history->count;
+    for (size_t i = 0; i < history->count; i++) {
+        if (strcmp(history->entries[i].query, query) == 0) {
+            pos = i;
+            break;
+        }
+    }
+
+    SearchHistoryEntry entry;
+    if (pos < history->count) {
+        // Decay the old count to the new timestamp and add this use
+        entry = history->entries[pos];
+        double age = difftime(when, entry.last_used);
+        if (age > 0) {
+            entry.score = entry.score * exp2(-age / SEARCH_HISTORY_HALF_LIFE) + weight;
+            entry.last_used = when;
+        } else {
+            entry.score += weight * exp2(age / SEARCH_HISTORY_HALF_LIFE);
+        }
+    } else {
+        char* copy = strdup(query);
+        if (!copy) return;
+
+        // Full: the lowest ranked entry sits at the end
+        if (history->count >= history->capacity) {
+            free(history->entries[history->count - 1].query);
+            history->count--;
+        }
+
+        pos = history->count++;
+        entry.query = copy;
+        entry.score = weight;
+        entry.last_used = when;
+    }
+    entry.rank = entry_rank(entry.score, entry.last_used);
+
+    // Ranks only grow on use, so the entry can only move towards the front
+    while (pos > 0 && history->entries[pos - 1].rank < entry.rank) {
+        history->entries[pos] = history->entries[pos - 1];
+        pos--;
+    }
+    history->entries[pos] = entry;
+}
+
+static void search_history_append_record(SearchHistory* history, const char* query,
+                                         time_t when, double weight) {
+    FILE* file = fopen(history->path, "a");
+    if (!file) return;
+
+    fprintf(file, "%lld %.6g %s\n", (long long)when, weight, query);
+    fclose(file);
+    history->log_records++;
+}
+
+static void search_history_compact(SearchHistory* history) {
+    size_t len = strlen(history->path);
+    char* tmp_path = malloc(len + 5);
+    if (!tmp_path) return;
+    sprintf(tmp_path, "%s.tmp", history->path);
+
+    FILE* file = fopen(tmp_path, "w");
+    if (!file) {
+        free(tmp_path);
+        return;
+    }
+
+    // One record per entry, best first so replaying needs no reordering
+    for (size_t i = 0; i < history->count; i++) {
+        const SearchHistoryEntry* entry = &history->entries[i];
+        fprintf(file, "%lld %.6g %s\n", (long long)entry->last_used,
+                entry->score, entry->query);
+    }
+
+    bool ok = fflush(file) == 0;
+    ok = fclose(file) == 0 && ok;
+
+    if (ok) {
+        remove(history->path);
+        ok = rename(tmp_path, history->path) == 0;
+    }
+    if (ok) {
+        history->log_records = history->count;
+    } else {
+        remove(tmp_path);
+    }
+
+    free(tmp_path);
+}
+
+static double entry_rank(double score, time_t last_used) {
+    // log2(score) + t / half-life orders entries by their decayed score at
+    // any common point in time, so the order never needs rebuilding as
+    // scores decay
+    return log2(score) + (double)last_used / SEARCH_HISTORY_HALF_LIFE;
+}
@@ -0,0 +1,224 @@
+#include "search_worker.h"
+#include "search.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct SearchWorker {
+    SDL_Thread* thread;
+    SDL_mutex* lock;
+    SDL_cond* wake;
+    SDL_atomic_t generation;
+    bool quit;
+
+    // Pending request (guarded by lock)
+    bool has_request;
+    Uint32 request_generation;
+    SearchContext request;
+    const Playlist* playlist;
+    ItemBitmap request_filter;
+    bool request_filtered;
+
+    // Streamed results (guarded by lock)
+    Uint32 result_generation;
+    ResultSet results;
+    bool done;
+};
+
+static int search_worker_thread(void* arg);
+
+SearchWorker* search_worker_create(void) {
+    SearchWorker* worker = calloc(1, sizeof(SearchWorker));
+    if (!worker) return NULL;
+
+    worker->lock = SDL_CreateMutex();
+    worker->wake = SDL_CreateCond();
+    if (!worker->lock || !worker->wake) {
+        if (worker->wake) SDL_DestroyCond(worker->wake);
+        if (worker->lock) SDL_DestroyMutex(worker->lock);
+        free(worker);
+        return NULL;
+    }
+
+    SDL_AtomicSet(&worker->generation, 0);
+    result_set_init(&worker->results);
+
+    worker->thread = SDL_CreateThread(search_worker_thread, "search", worker);
+    if (!worker->thread) {
+        SDL_DestroyCond(worker->wake);
+        SDL_DestroyMutex(worker->lock);
+        free(worker);
+        return NULL;
+    }
+
+    return worker;
+}
+
+void search_worker_free(SearchWorker* worker) {
+    if (!worker) return;
+
+    // Abort the running query and wake the thread so it can exit
+    SDL_AtomicAdd(&worker->generation, 1);
+    SDL_LockMutex(worker->lock);
+    worker->quit = true;
+    SDL_CondSignal(worker->wake);
+    SDL_UnlockMutex(worker->lock);
+
+    SDL_WaitThread(worker->thread, NULL);
+
+    if (worker->has_request) {
+        free(worker->request.selected_category);
+    }
+    result_set_free(&worker->results);
+    item_bitmap_free(&worker->request_filter);
+    SDL_DestroyCond(worker->wake);
+    SDL_DestroyMutex(worker->lock);
+    free(worker);
+}
+
+Uint32 search_worker_submit(SearchWorker* worker, const Playlist* playlist,
+                            const SearchContext* query, const ItemBitmap* visible) {
+    // Bumping the generation first lets a running scan bail out at its next
+    // batch boundary without waiting for the lock
+    Uint32 generation = (Uint32)SDL_AtomicAdd(&worker->generation, 1) + 1;
+
+    char* category = query->selected_category ? strdup(query->selected_category) : NULL;
+
+    SDL_LockMutex(worker->lock);
+
+    if (worker->has_request) {
+        free(worker->request.selected_category);
+    }
+
+    worker->request = *query;
+    result_set_init(&worker->request.results);
+    worker->request.selected_category = category;
+    worker->request_generation = generation;
+    worker->playlist = playlist;
+    worker->has_request = true;
+
+    // Snapshot the visible set so filter toggles cannot race the scan
+    worker->request_filtered = visible &&
+        item_bitmap_resize(&worker->request_filter, visible->bit_count);
+    if (worker->request_filtered) {
+        memcpy(worker->request_filter.words, visible->words,
+               ITEM_BITMAP_WORDS(visible->bit_count) * sizeof(uint64_t));
+    }
+
+    // Drop results streamed for the previous query
+    worker->result_generation = generation;
+    result_set_clear(&worker->results);
+    worker->done = false;
+
+    SDL_CondSignal(worker->wake);
+    SDL_UnlockMutex(worker->lock);
+
+    return generation;
+}
+
+void search_worker_cancel(SearchWorker* worker) {
+    if (worker) SDL_AtomicAdd(&worker->generation, 1);
+}
+
+bool search_worker_poll(SearchWorker* worker, Uint32 generation,
+                        SearchContext* out, bool* done) {
+    // The UI thread must never stall on the worker; if it is busy handing
+    // over a batch right now, try again next frame
+    if (SDL_TryLockMutex(worker->lock) != 0) return false;
+
+    if (worker->result_generation != generation) {
+        SDL_UnlockMutex(worker->lock);
+        return false;
+    }
+
+    bool changed = worker->results.count > 0 || worker->done;
+    *done = worker->done;
+
+    if (out->results.capacity == 0) {
+        // First batch: adopt the worker's buffer instead of copying it
+        out->results = worker->results;
+        result_set_init(&worker->results);
+    } else {
+        result_set_append(&out->results, worker->results.indices, worker->results.count);
+        result_set_clear(&worker->results);
+    }
+
+    SDL_UnlockMutex(worker->lock);
+    return changed;
+}
+
+static int search_worker_thread(void* arg) {
+    SearchWorker* worker = (SearchWorker*)arg;
+    uint32_t* batch = malloc(SEARCH_BATCH_SIZE * sizeof(uint32_t));
+    if (!batch) return -1;
+
+    ItemBitmap filter = {0};
+
+    SDL_LockMutex(worker->lock);
+
+    while (!worker->quit) {
+        if (!worker->has_request) {
+            SDL_CondWait(worker->wake, worker->lock);
+            continue;
+        }
+
+        // Take ownership of the request and scan without holding the lock
+        SearchContext query = worker->request;
+        const Playlist* playlist = worker->playlist;
+        Uint32 generation = worker->request_generation;
+        bool filtered = worker->request_filtered;
+        worker->has_request = false;
+
+        // Swap buffers with the request slot instead of copying
+        ItemBitmap tmp = filter;
+        filter = worker->request_filter;
+        worker->request_filter = tmp;
+
+        SDL_UnlockMutex(worker->lock);
+
+        bool cancelled = false;
+        size_t i = 0;
+        size_t total = playlist ? playlist->count : 0;
+        if (filtered && filter.bit_count < total) total = filter.bit_count;
+
+        while (i < total) {
+            size_t end = MIN(i + SEARCH_BATCH_SIZE, total);
+            size_t count = 0;
+
+            for (; i < end; i++) {
+                // With a filter snapshot only the query text is left to check
+                if (filtered) {
+                    if (!item_bitmap_test(&filter, (uint32_t)i)) continue;
+                    if (!search_matches_query(&query, &playlist->items[i])) continue;
+                } else if (!search_matches_item(&query, &playlist->items[i])) {
+                    continue;
+                }
+                batch[count++] = (uint32_t)i;
+            }
+
+            if ((Uint32)SDL_AtomicGet(&worker->generation) != generation) {
+                cancelled = true;
+                break;
+            }
+
+            if (count > 0) {
+                SDL_LockMutex(worker->lock);
+                if (worker->result_generation == generation) {
+                    result_set_append(&worker->results, batch, count);
+                }
+                SDL_UnlockMutex(worker->lock);
+            }
+        }
+
+        free(query.selected_category);
+
+        SDL_LockMutex(worker->lock);
+        if (!cancelled && worker->result_generation == generation) {
+            worker->done = true;
+        }
+    }
+
+    SDL_UnlockMutex(worker->lock);
+    item_bitmap_free(&filter);
+    free(batch);
+    return 0;
+}
@@ -0,0 +1,26 @@
+#ifndef SEARCH_WORKER_H
+#define SEARCH_WORKER_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include "ui.h"
+
+// Number of items scanned between cancellation checks and result hand-offs
+#define SEARCH_BATCH_SIZE 512
+
+// Background search worker
+//
+// Every submitted query gets a new generation number. The worker checks the
+// current generation after each batch and drops its work as soon as a newer
+// query is submitted, so only the latest keystroke runs to completion.
+// Matches are streamed back in batches and collected by the UI thread with
+// search_worker_poll, which never blocks.
+SearchWorker* search_worker_create(void);
+void search_worker_free(SearchWorker* worker);
+Uint32 search_worker_submit(SearchWorker* worker, const Playlist* playlist,
+                            const SearchContext* query, const ItemBitmap* visible);
+void search_worker_cancel(SearchWorker* worker);
+bool search_worker_poll(SearchWorker* worker, Uint32 generation,
+                        SearchContext* out, bool* done);
+
+#endif // SEARCH_WORKER_H
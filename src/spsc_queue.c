@@ -0,0 +1,58 @@
+#include "spsc_queue.h"
+#include <stdlib.h>
+
+bool spsc_queue_init(SpscQueue* queue, size_t capacity) {
+    // Round up so a slot is found with a mask
+    size_t slots = 1;
+    while (slots < capacity) slots <<= 1;
+
+    queue->slots = calloc(slots, sizeof(void*));
+    if (!queue->slots) return false;
+
+    queue->mask = (Uint32)(slots - 1);
+    SDL_AtomicSet(&queue->head, 0);
+    SDL_AtomicSet(&queue->tail, 0);
+    return true;
+}
+
+void spsc_queue_free(SpscQueue* queue) {
+    // Items still queued belong to the caller, who drains them first
+    free(queue->slots);
+    queue->slots = NULL;
+}
+
+bool spsc_queue_push(SpscQueue* queue, void* item) {
+    Uint32 tail = (Uint32)SDL_AtomicGet(&queue->tail);
+    Uint32 head = (Uint32)SDL_AtomicGet(&queue->head);
+    if (tail - head > queue->mask) return false;
+
+    queue->slots[tail & queue->mask] = item;
+    SDL_AtomicSet(&queue->tail, (int)(tail + 1));
+    return true;
+}
+
+void* spsc_queue_pop(SpscQueue* queue) {
+    Uint32 head = (Uint32)SDL_AtomicGet(&queue->head);
+    Uint32 tail = (Uint32)SDL_AtomicGet(&queue->tail);
+    if (head == tail) return NULL;
+
+    void* item = queue->slots[head & queue->mask];
+    SDL_AtomicSet(&queue->head, (int)(head + 1));
+    return item;
+}
+
+void* spsc_queue_peek(SpscQueue* queue) {
+    // The slot stays the consumer's until it pops it
+    Uint32 head = (Uint32)SDL_AtomicGet(&queue->head);
+    Uint32 tail = (Uint32)SDL_AtomicGet(&queue->tail);
+    if (head == tail) return NULL;
+
+    return queue->slots[head & queue->mask];
+}
+
+size_t spsc_queue_count(SpscQueue* queue) {
+    // Exact from either end; a snapshot from anywhere else
+    Uint32 head = (Uint32)SDL_AtomicGet(&queue->head);
+    Uint32 tail = (Uint32)SDL_AtomicGet(&queue->tail);
+    return tail - head;
+}
@@ -0,0 +1,30 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bounded single-producer single-consumer queue of pointers
+//
+// A ring of slots indexed by two free-running counters: the producer only
+// advances tail and the consumer only advances head, so neither side takes
+// a lock. The counters are SDL atomics, whose full barriers publish a slot
+// before the index that makes it visible. NULL cannot be queued; pop and
+// peek return it when the queue is empty. A full queue refuses the push,
+// and the producer decides whether to wait or drop.
+typedef struct {
+    void** slots;
+    Uint32 mask;              // Capacity - 1, capacity a power of two
+    SDL_atomic_t head;        // Next slot to pop, written by the consumer
+    SDL_atomic_t tail;        // Next slot to push, written by the producer
+} SpscQueue;
+
+bool spsc_queue_init(SpscQueue* queue, size_t capacity);
+void spsc_queue_free(SpscQueue* queue);
+bool spsc_queue_push(SpscQueue* queue, void* item);
+void* spsc_queue_pop(SpscQueue* queue);
+void* spsc_queue_peek(SpscQueue* queue);
+size_t spsc_queue_count(SpscQueue* queue);
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,228 @@
+#include "text_cache.h"
+#include "texture_registry.h"
+#include "ui_constants.h"
+#include "hash.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TEXT_CACHE_INITIAL_BUCKETS 256
+
+// Cached texture, linked into a hash chain and the LRU list
+typedef struct TextCacheEntry {
+    uint64_t hash;
+    char* text;
+    TTF_Font* font;
+    SDL_Renderer* renderer;
+    SDL_Color color;
+    int style;
+
+    SDL_Texture* texture;
+    int w;
+    int h;
+    size_t bytes;
+
+    struct TextCacheEntry* chain;
+    struct TextCacheEntry* prev;   // Towards most recently used
+    struct TextCacheEntry* next;   // Towards least recently used
+} TextCacheEntry;
+
+static struct {
+    TextCacheEntry** buckets;
+    size_t bucket_count;
+    TextCacheEntry* head;          // Most recently used
+    TextCacheEntry* tail;          // Least recently used
+    size_t budget;
+    TextCacheStats stats;
+} cache = { .budget = TEXT_CACHE_BUDGET };
+
+static uint64_t entry_hash(SDL_Renderer* renderer, TTF_Font* font, const char* text,
+                           SDL_Color color, int style);
+static bool grow_buckets(void);
+static void lru_unlink(TextCacheEntry* entry);
+static void lru_push_front(TextCacheEntry* entry);
+static void remove_entry(TextCacheEntry* entry);
+static void evict_to_budget(void);
+static bool reclaim_textures(void* context, size_t bytes);
+
+SDL_Texture* text_cache_get(SDL_Renderer* renderer, TTF_Font* font, const char* text,
+                            SDL_Color color, int* w, int* h) {
+    if (!renderer || !font || !text || !text[0]) return NULL;
+
+    if (!cache.buckets) {
+        if (!grow_buckets()) return NULL;
+        texture_registry_set_reclaimer(TEXTURE_CLASS_TEXT, reclaim_textures, NULL);
+    }
+
+    int style = TTF_GetFontStyle(font);
+    uint64_t hash = entry_hash(renderer, font, text, color, style);
+    TextCacheEntry** bucket = &cache.buckets[hash & (cache.bucket_count - 1)];
+
+    for (TextCacheEntry* entry = *bucket; entry; entry = entry->chain) {
+        if (entry->hash == hash && entry->font == font && entry->renderer == renderer &&
+            entry->style == style && memcmp(&entry->color, &color, sizeof(SDL_Color)) == 0 &&
+            strcmp(entry->text, text) == 0) {
+            cache.stats.hits++;
+            if (cache.head != entry) {
+                lru_unlink(entry);
+                lru_push_front(entry);
+            }
+            if (w) *w = entry->w;
+            if (h) *h = entry->h;
+            return entry->texture;
+        }
+    }
+
+    cache.stats.misses++;
+
+    SDL_Surface* surface = TTF_RenderUTF8_Blended(font, text, color);
+    if (!surface) return NULL;
+
+    TextCacheEntry* entry = calloc(1, sizeof(TextCacheEntry));
+    if (entry) {
+        entry->text = strdup(text);
+        entry->texture = texture_registry_create_from_surface(renderer, TEXTURE_CLASS_TEXT,
+                                                              surface);
+    }
+    if (!entry || !entry->text || !entry->texture) {
+        if (entry) {
+            texture_registry_destroy(entry->texture);
+            free(entry->text);
+            free(entry);
+        }
+        SDL_FreeSurface(surface);
+        return NULL;
+    }
+
+    entry->hash = hash;
+    entry->font = font;
+    entry->renderer = renderer;
+    entry->color = color;
+    entry->style = style;
+    entry->w = surface->w;
+    entry->h = surface->h;
+    entry->bytes = (size_t)surface->w * surface->h * 4;
+    SDL_FreeSurface(surface);
+
+    if (cache.stats.entries + 1 > cache.bucket_count) {
+        grow_buckets();
+        bucket = &cache.buckets[hash & (cache.bucket_count - 1)];
+    }
+
+    entry->chain = *bucket;
+    *bucket = entry;
+    lru_push_front(entry);
+    cache.stats.entries++;
+    cache.stats.bytes += entry->bytes;
+
+    if (w) *w = entry->w;
+    if (h) *h = entry->h;
+
+    // The entry just added is at the head, so it is evicted last
+    SDL_Texture* texture = entry->texture;
+    evict_to_budget();
+    return texture;
+}
+
+void text_cache_set_budget(size_t bytes) {
+    cache.budget = bytes;
+    evict_to_budget();
+}
+
+void text_cache_get_stats(TextCacheStats* stats) {
+    if (stats) *stats = cache.stats;
+}
+
+void text_cache_clear(void) {
+    while (cache.tail) {
+        remove_entry(cache.tail);
+    }
+
+    free(cache.buckets);
+    cache.buckets = NULL;
+    cache.bucket_count = 0;
+    texture_registry_set_reclaimer(TEXTURE_CLASS_TEXT, NULL, NULL);
+}
+
+static uint64_t entry_hash(SDL_Renderer* renderer, TTF_Font* font, const char* text,
+                           SDL_Color color, int style) {
+    uint64_t hash = hash_string64(FNV64_OFFSET, text);
+    hash = hash_bytes64(hash, &font, sizeof(font));
+    hash = hash_bytes64(hash, &renderer, sizeof(renderer));
+    hash = hash_bytes64(hash, &color, sizeof(color));
+    return hash_bytes64(hash, &style, sizeof(style));
+}
+
+static bool grow_buckets(void) {
+    size_t count = cache.bucket_count ? cache.bucket_count * 2 : TEXT_CACHE_INITIAL_BUCKETS;
+    TextCacheEntry** buckets = calloc(count, sizeof(TextCacheEntry*));
+    if (!buckets) return false;
+
+    // Rehash by walking the LRU list, which holds every entry
+    for (TextCacheEntry* entry = cache.head; entry; entry = entry->next) {
+        TextCacheEntry** bucket = &buckets[entry->hash & (count - 1)];
+        entry->chain = *bucket;
+        *bucket = entry;
+    }
+
+    free(cache.buckets);
+    cache.buckets = buckets;
+    cache.bucket_count = count;
+    return true;
+}
+
+static void lru_unlink(TextCacheEntry* entry) {
+    if (entry->prev) entry->prev->next = entry->next;
+    else cache.head = entry->next;
+
+    if (entry->next) entry->next->prev = entry->prev;
+    else cache.tail = entry->prev;
+
+    entry->prev = NULL;
+    entry->next = NULL;
+}
+
+static void lru_push_front(TextCacheEntry* entry) {
+    entry->prev = NULL;
+    entry->next = cache.head;
+    if (cache.head) cache.head->prev = entry;
+    cache.head = entry;
+    if (!cache.tail) cache.tail = entry;
+}
+
+static void remove_entry(TextCacheEntry* entry) {
+    TextCacheEntry** link = &cache.buckets[entry->hash & (cache.bucket_count - 1)];
+    while (*link != entry) {
+        link = &(*link)->chain;
+    }
+    *link = entry->chain;
+
+    lru_unlink(entry);
+    cache.stats.entries--;
+    cache.stats.bytes -= entry->bytes;
+
+    texture_registry_destroy(entry->texture);
+    free(entry->text);
+    free(entry);
+}
+
+static void evict_to_budget(void) {
+    // Always keep the most recent entry so an oversized string still draws
+    while (cache.stats.bytes > cache.budget && cache.tail && cache.tail != cache.head) {
+        remove_entry(cache.tail);
+        cache.stats.evictions++;
+    }
+}
+
+static bool reclaim_textures(void* context, size_t bytes) {
+    (void)context;
+
+    // The head stays, as in evict_to_budget; an entry being created is not
+    // linked yet, so it is safe from this
+    size_t freed = 0;
+    while (freed < bytes && cache.tail && cache.tail != cache.head) {
+        freed += cache.tail->bytes;
+        remove_entry(cache.tail);
+        cache.stats.evictions++;
+    }
+    return freed > 0;
+}
@@ -0,0 +1,29 @@
+#ifndef TEXT_CACHE_H
+#define TEXT_CACHE_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Text cache counters
+typedef struct {
+    Uint64 hits;
+    Uint64 misses;
+    Uint64 evictions;
+    size_t bytes;
+    size_t entries;
+} TextCacheStats;
+
+// Rendered text texture cache
+//
+// Whole strings rendered by TTF are kept as textures keyed by a hash of
+// (text, font, color, style) and evicted least recently used first once
+// their pixel bytes exceed the budget.
+SDL_Texture* text_cache_get(SDL_Renderer* renderer, TTF_Font* font, const char* text,
+                            SDL_Color color, int* w, int* h);
+void text_cache_set_budget(size_t bytes);
+void text_cache_get_stats(TextCacheStats* stats);
+void text_cache_clear(void);
+
+#endif // TEXT_CACHE_H
@@ -0,0 +1,424 @@
+#include "text_renderer.h"
+#include "text_cache.h"
+#include "profiler.h"
+#include "render_batch.h"
+#include "texture_registry.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ATLAS_INITIAL_SLOTS 256
+#define ATLAS_PADDING 1
+#define BATCH_INITIAL_QUADS 256
+
+// Glyph cached in an atlas
+typedef struct {
+    Uint32 codepoint;   // 0 marks an empty slot
+    SDL_Rect rect;      // Location in the atlas texture
+    int advance;
+} AtlasGlyph;
+
+// Atlas and pending quads for one (renderer, font, style)
+typedef struct TextAtlas {
+    SDL_Renderer* renderer;
+    TTF_Font* font;
+    int style;
+    SDL_Texture* texture;
+
+    // Glyph table, open addressing on the codepoint
+    AtlasGlyph* glyphs;
+    size_t glyph_slots;
+    size_t glyph_count;
+
+    // Shelf packer state
+    int shelf_x;
+    int shelf_y;
+    int shelf_height;
+
+    // Queued quads
+    SDL_Vertex* vertices;
+    int* indices;
+    int quad_count;
+    int quad_capacity;
+
+    struct TextAtlas* next;
+} TextAtlas;
+
+static TextAtlas* atlases;
+static TextAtlas* pending;  // Only one atlas holds queued quads at a time
+
+static TextAtlas* get_atlas(SDL_Renderer* renderer, TTF_Font* font);
+static const AtlasGlyph* get_glyph(TextAtlas* atlas, Uint32 codepoint);
+static AtlasGlyph* find_slot(AtlasGlyph* glyphs, size_t slots, Uint32 codepoint);
+static bool grow_glyph_table(TextAtlas* atlas);
+static void reset_atlas(TextAtlas* atlas);
+static void flush_atlas(TextAtlas* atlas);
+static bool push_quad(TextAtlas* atlas, const SDL_Rect* src, int x, int y, SDL_Color color);
+static Uint32 decode_utf8(const char** text);
+static bool needs_shaping(Uint32 codepoint);
+static bool text_needs_shaping(const char* text);
+static void draw_glyphs(TextAtlas* atlas, const char* text,
+                        int x, int y, SDL_Color color, bool centered);
+static void draw_shaped(SDL_Renderer* renderer, TTF_Font* font, const char* text,
+                        int x, int y, SDL_Color color, bool centered);
+
+void text_renderer_draw(SDL_Renderer* renderer, TTF_Font* font, const char* text,
+                        int x, int y, SDL_Color color, bool centered) {
+    if (!renderer || !font || !text || !text[0]) return;
+
+    Uint64 start = profiler_begin();
+    TextAtlas* atlas = text_needs_shaping(text) ? NULL : get_atlas(renderer, font);
+    if (atlas) {
+        draw_glyphs(atlas, text, x, y, color, centered);
+    } else {
+        draw_shaped(renderer, font, text, x, y, color, centered);
+    }
+    profiler_end(PROFILER_PHASE_TEXT, start);
+}
+
+int text_renderer_measure(SDL_Renderer* renderer, TTF_Font* font, const char* text) {
+    if (!font || !text) return 0;
+
+    TextAtlas* atlas = get_atlas(renderer, font);
+    if (!atlas || text_needs_shaping(text)) {
+        int w = 0;
+        TTF_SizeUTF8(font, text, &w, NULL);
+        return w;
+    }
+
+    int width = 0;
+    Uint32 previous = 0;
+    const char* p = text;
+    while (*p) {
+        Uint32 codepoint = decode_utf8(&p);
+
+        if (previous) {
+            width += TTF_GetFontKerningSizeGlyphs32(font, previous, codepoint);
+        }
+        previous = codepoint;
+
+        const AtlasGlyph* glyph = get_glyph(atlas, codepoint);
+        if (glyph) width += glyph->advance;
+    }
+    return width;
+}
+
+void text_renderer_flush(SDL_Renderer* renderer) {
+    if (pending && (!renderer || pending->renderer == renderer)) {
+        Uint64 start = profiler_begin();
+        flush_atlas(pending);
+        pending = NULL;
+        profiler_end(PROFILER_PHASE_TEXT, start);
+    }
+}
+
+void text_renderer_shutdown(void) {
+    pending = NULL;
+    text_cache_clear();
+
+    while (atlases) {
+        TextAtlas* atlas = atlases;
+        atlases = atlas->next;
+
+        texture_registry_destroy(atlas->texture);
+        free(atlas->glyphs);
+        free(atlas->vertices);
+        free(atlas->indices);
+        free(atlas);
+    }
+}
+
+static void draw_glyphs(TextAtlas* atlas, const char* text,
+                        int x, int y, SDL_Color color, bool centered) {
+    SDL_Renderer* renderer = atlas->renderer;
+    TTF_Font* font = atlas->font;
+
+    if (centered) {
+        x -= text_renderer_measure(renderer, font, text) / 2;
+    }
+
+    // Quads of different atlases cannot share a draw call
+    if (pending && pending != atlas) {
+        flush_atlas(pending);
+    }
+    pending = atlas;
+
+    int pen_x = x;
+    Uint32 previous = 0;
+    const char* p = text;
+    while (*p) {
+        Uint32 codepoint = decode_utf8(&p);
+
+        if (previous) {
+            pen_x += TTF_GetFontKerningSizeGlyphs32(font, previous, codepoint);
+        }
+        previous = codepoint;
+
+        const AtlasGlyph* glyph = get_glyph(atlas, codepoint);
+        if (!glyph) continue;
+
+        if (glyph->rect.w > 0 && !push_quad(atlas, &glyph->rect, pen_x, y, color)) break;
+        pen_x += glyph->advance;
+    }
+}
+
+static TextAtlas* get_atlas(SDL_Renderer* renderer, TTF_Font* font) {
+    int style = TTF_GetFontStyle(font);
+
+    for (TextAtlas* atlas = atlases; atlas; atlas = atlas->next) {
+        if (atlas->renderer == renderer && atlas->font == font && atlas->style == style) {
+            return atlas;
+        }
+    }
+
+    TextAtlas* atlas = calloc(1, sizeof(TextAtlas));
+    if (!atlas) return NULL;
+
+    atlas->renderer = renderer;
+    atlas->font = font;
+    atlas->style = style;
+    atlas->glyph_slots = ATLAS_INITIAL_SLOTS;
+    atlas->glyphs = calloc(atlas->glyph_slots, sizeof(AtlasGlyph));
+    atlas->texture = texture_registry_create(renderer, TEXTURE_CLASS_GLYPHS,
+                                             SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC,
+                                             TEXT_ATLAS_SIZE, TEXT_ATLAS_SIZE);
+    if (!atlas->glyphs || !atlas->texture) {
+        texture_registry_destroy(atlas->texture);
+        free(atlas->glyphs);
+        free(atlas);
+        return NULL;
+    }
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+
+    atlas->next = atlases;
+    atlases = atlas;
+    return atlas;
+}
+
+static const AtlasGlyph* get_glyph(TextAtlas* atlas, Uint32 codepoint) {
+    AtlasGlyph* slot = find_slot(atlas->glyphs, atlas->glyph_slots, codepoint);
+    if (slot->codepoint == codepoint) return slot;
+
+    int advance = 0;
+    if (TTF_GlyphMetrics32(atlas->font, codepoint, NULL, NULL, NULL, NULL, &advance) != 0) {
+        return NULL;
+    }
+
+    // Rendered white; the vertex color tints it at draw time
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Surface* surface = NULL;
+    if (codepoint != ' ') {
+        surface = TTF_RenderGlyph32_Blended(atlas->font, codepoint, white);
+        if (!surface) return NULL;
+    }
+
+    int w = surface ? surface->w : 0;
+    int h = surface ? surface->h : 0;
+    if (w + ATLAS_PADDING > TEXT_ATLAS_SIZE || h + ATLAS_PADDING > TEXT_ATLAS_SIZE) {
+        SDL_FreeSurface(surface);
+        return NULL;
+    }
+
+    // Next shelf, or start over once the atlas is full
+    if (atlas->shelf_x + w + ATLAS_PADDING > TEXT_ATLAS_SIZE) {
+        atlas->shelf_x = 0;
+        atlas->shelf_y += atlas->shelf_height;
+        atlas->shelf_height = 0;
+    }
+    if (atlas->shelf_y + h + ATLAS_PADDING > TEXT_ATLAS_SIZE) {
+        reset_atlas(atlas);
+    }
+
+    if ((atlas->glyph_count + 1) * 2 > atlas->glyph_slots && !grow_glyph_table(atlas)) {
+        SDL_FreeSurface(surface);
+        return NULL;
+    }
+
+    SDL_Rect rect = {atlas->shelf_x, atlas->shelf_y, w, h};
+    if (surface) {
+        SDL_Surface* converted = surface;
+        if (surface->format->format != SDL_PIXELFORMAT_ARGB8888) {
+            converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+        }
+        if (converted) {
+            SDL_UpdateTexture(atlas->texture, &rect, converted->pixels, converted->pitch);
+            if (converted != surface) SDL_FreeSurface(converted);
+        }
+        SDL_FreeSurface(surface);
+    }
+
+    atlas->shelf_x += w + ATLAS_PADDING;
+    if (h + ATLAS_PADDING > atlas->shelf_height) {
+        atlas->shelf_height = h + ATLAS_PADDING;
+    }
+
+    slot = find_slot(atlas->glyphs, atlas->glyph_slots, codepoint);
+    slot->codepoint = codepoint;
+    slot->rect = rect;
+    slot->advance = advance;
+    atlas->glyph_count++;
+    return slot;
+}
+
+static AtlasGlyph* find_slot(AtlasGlyph* glyphs, size_t slots, Uint32 codepoint) {
+    size_t mask = slots - 1;
+    size_t pos = (codepoint * 2654435761u) & mask;
+
+    while (glyphs[pos].codepoint && glyphs[pos].codepoint != codepoint) {
+        pos = (pos + 1) & mask;
+    }
+    return &glyphs[pos];
+}
+
+static bool grow_glyph_table(TextAtlas* atlas) {
+    size_t slots = atlas->glyph_slots * 2;
+    AtlasGlyph* glyphs = calloc(slots, sizeof(AtlasGlyph));
+    if (!glyphs) return false;
+
+    for (size_t i = 0; i < atlas->glyph_slots; i++) {
+        if (atlas->glyphs[i].codepoint) {
+            *find_slot(glyphs, slots, atlas->glyphs[i].codepoint) = atlas->glyphs[i];
+        }
+    }
+
+    free(atlas->glyphs);
+    atlas->glyphs = glyphs;
+    atlas->glyph_slots = slots;
+    return true;
+}
+
+static void reset_atlas(TextAtlas* atlas) {
+    // Queued quads still point at the old contents
+    if (pending == atlas) {
+        flush_atlas(atlas);
+    }
+
+    memset(atlas->glyphs, 0, atlas->glyph_slots * sizeof(AtlasGlyph));
+    atlas->glyph_count = 0;
+    atlas->shelf_x = 0;
+    atlas->shelf_y = 0;
+    atlas->shelf_height = 0;
+}
+
+static void flush_atlas(TextAtlas* atlas) {
+    if (atlas->quad_count == 0) return;
+
+    SDL_RenderGeometry(atlas->renderer, atlas->texture,
+                       atlas->vertices, atlas->quad_count * 4,
+                       atlas->indices, atlas->quad_count * 6);
+    atlas->quad_count = 0;
+}
+
+static bool push_quad(TextAtlas* atlas, const SDL_Rect* src, int x, int y, SDL_Color color) {
+    if (atlas->quad_count == atlas->quad_capacity) {
+        int capacity = atlas->quad_capacity ? atlas->quad_capacity * 2 : BATCH_INITIAL_QUADS;
+        SDL_Vertex* vertices = realloc(atlas->vertices, capacity * 4 * sizeof(SDL_Vertex));
+        if (vertices) atlas->vertices = vertices;
+        int* indices = realloc(atlas->indices, capacity * 6 * sizeof(int));
+        if (indices) atlas->indices = indices;
+        if (!vertices || !indices) return false;
+
+        // Index pattern is fixed per quad, so only new quads need filling
+        for (int q = atlas->quad_capacity; q < capacity; q++) {
+            int* idx = &atlas->indices[q * 6];
+            idx[0] = q * 4;
+            idx[1] = q * 4 + 1;
+            idx[2] = q * 4 + 2;
+            idx[3] = q * 4;
+            idx[4] = q * 4 + 2;
+            idx[5] = q * 4 + 3;
+        }
+        atlas->quad_capacity = capacity;
+    }
+
+    float u0 = (float)src->x / TEXT_ATLAS_SIZE;
+    float v0 = (float)src->y / TEXT_ATLAS_SIZE;
+    float u1 = (float)(src->x + src->w) / TEXT_ATLAS_SIZE;
+    float v1 = (float)(src->y + src->h) / TEXT_ATLAS_SIZE;
+    float x0 = (float)x;
+    float y0 = (float)y;
+    float x1 = (float)(x + src->w);
+    float y1 = (float)(y + src->h);
+
+    SDL_Vertex* v = &atlas->vertices[atlas->quad_count * 4];
+    v[0] = (SDL_Vertex){{x0, y0}, color, {u0, v0}};
+    v[1] = (SDL_Vertex){{x1, y0}, color, {u1, v0}};
+    v[2] = (SDL_Vertex){{x1, y1}, color, {u1, v1}};
+    v[3] = (SDL_Vertex){{x0, y1}, color, {u0, v1}};
+
+    atlas->quad_count++;
+    return true;
+}
+
+static Uint32 decode_utf8(const char** text) {
+    const unsigned char* p = (const unsigned char*)*text;
+    Uint32 codepoint;
+    int extra;
+
+    if (p[0] < 0x80) {
+        codepoint = p[0];
+        extra = 0;
+    } else if ((p[0] & 0xE0) == 0xC0) {
+        codepoint = p[0] & 0x1F;
+        extra = 1;
+    } else if ((p[0] & 0xF0) == 0xE0) {
+        codepoint = p[0] & 0x0F;
+        extra = 2;
+    } else if ((p[0] & 0xF8) == 0xF0) {
+        codepoint = p[0] & 0x07;
+        extra = 3;
+    } else {
+        // Stray continuation or invalid lead byte
+        *text += 1;
+        return 0xFFFD;
+    }
+
+    for (int i = 1; i <= extra; i++) {
+        if ((p[i] & 0xC0) != 0x80) {
+            *text += i;
+            return 0xFFFD;
+        }
+        codepoint = (codepoint << 6) | (p[i] & 0x3F);
+    }
+
+    *text += extra + 1;
+    return codepoint;
+}
+
+static bool needs_shaping(Uint32 codepoint) {
+    return (codepoint >= 0x0300 && codepoint <= 0x036F) ||   // Combining marks
+           (codepoint >= 0x0590 && codepoint <= 0x08FF) ||   // Hebrew, Arabic, Syriac
+           (codepoint >= 0x0900 && codepoint <= 0x0DFF) ||   // Indic
+           (codepoint >= 0x0E00 && codepoint <= 0x0EFF) ||   // Thai, Lao
+           (codepoint >= 0x0F00 && codepoint <= 0x109F) ||   // Tibetan, Myanmar
+           (codepoint >= 0x1780 && codepoint <= 0x17FF) ||   // Khmer
+           (codepoint >= 0xFB1D && codepoint <= 0xFEFF);     // Presentation forms
+}
+
+static bool text_needs_shaping(const char* text) {
+    // Plain ASCII never needs shaping
+    for (const char* p = text; *p;) {
+        if ((unsigned char)*p < 0x80) {
+            p++;
+            continue;
+        }
+        if (needs_shaping(decode_utf8(&p))) return true;
+    }
+    return false;
+}
+
+static void draw_shaped(SDL_Renderer* renderer, TTF_Font* font, const char* text,
+                        int x, int y, SDL_Color color, bool centered) {
+    // Keep the draw order with queued rects and glyph quads
+    render_batch_flush(renderer);
+
+    // Shaped strings are cached whole since their glyphs cannot be reused
+    SDL_Rect dest = {x, y, 0, 0};
+    SDL_Texture* texture = text_cache_get(renderer, font, text, color, &dest.w, &dest.h);
+    if (!texture) return;
+
+    if (centered) {
+        dest.x -= dest.w / 2;
+    }
+
+    SDL_RenderCopy(renderer, texture, NULL, &dest);
+}
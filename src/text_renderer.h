@@ -0,0 +1,26 @@
+#ifndef TEXT_RENDERER_H
+#define TEXT_RENDERER_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <stdbool.h>
+
+#define TEXT_ATLAS_SIZE 1024
+
+// Glyph atlas text renderer
+//
+// Glyphs are rasterized once per (renderer, font, style) into a single atlas
+// texture and text is drawn as textured quads tinted through vertex colors.
+// Quads are queued and submitted with one SDL_RenderGeometry call per atlas,
+// so anything that must appear above text drawn earlier in the frame has to
+// call text_renderer_flush first. Strings in scripts that need shaping
+// (Arabic, Indic, Thai, combining marks) are rendered whole by
+// TTF_RenderUTF8_Blended, which shapes with HarfBuzz, and kept in the text
+// cache.
+void text_renderer_draw(SDL_Renderer* renderer, TTF_Font* font, const char* text,
+                        int x, int y, SDL_Color color, bool centered);
+int text_renderer_measure(SDL_Renderer* renderer, TTF_Font* font, const char* text);
+void text_renderer_flush(SDL_Renderer* renderer);
+void text_renderer_shutdown(void);
+
+#endif // TEXT_RENDERER_H
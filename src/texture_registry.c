@@ -0,0 +1,170 @@
+#include "texture_registry.h"
+#include "render_batch.h"
+#include "ui_constants.h"
+#include "hash.h"
+#include <stdlib.h>
+
+#define TEXTURE_REGISTRY_BUCKETS 256
+
+// Live texture and what it costs
+typedef struct TextureRecord {
+    SDL_Texture* texture;
+    size_t bytes;
+    TextureClass cls;
+    struct TextureRecord* chain;
+} TextureRecord;
+
+static struct {
+    TextureRecord* buckets[TEXTURE_REGISTRY_BUCKETS];
+    TextureReclaimFunc reclaimers[TEXTURE_CLASS_COUNT];
+    void* contexts[TEXTURE_CLASS_COUNT];
+    bool reclaiming;
+    TextureRegistryStats stats;
+} registry = { .stats.budget = TEXTURE_BUDGET };
+
+static bool make_room(TextureClass cls, size_t bytes);
+static void track(SDL_Texture* texture, TextureClass cls);
+static size_t texture_bytes(Uint32 format, int w, int h);
+static TextureRecord** find_link(SDL_Texture* texture);
+static TextureRecord** bucket_of(SDL_Texture* texture);
+
+SDL_Texture* texture_registry_create(SDL_Renderer* renderer, TextureClass cls, Uint32 format,
+                                     int access, int w, int h) {
+    if (!make_room(cls, texture_bytes(format, w, h))) return NULL;
+
+    SDL_Texture* texture = SDL_CreateTexture(renderer, format, access, w, h);
+    if (texture) track(texture, cls);
+    return texture;
+}
+
+SDL_Texture* texture_registry_create_from_surface(SDL_Renderer* renderer, TextureClass cls,
+                                                  SDL_Surface* surface) {
+    // The renderer picks the format; four bytes a pixel is what it picks
+    // for blended text
+    size_t bytes = texture_bytes(SDL_PIXELFORMAT_RGBA32, surface->w, surface->h);
+    if (!make_room(cls, bytes)) return NULL;
+
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (texture) track(texture, cls);
+    return texture;
+}
+
+void texture_registry_destroy(SDL_Texture* texture) {
+    if (!texture) return;
+
+    // Textures created before a record could be allocated are just freed
+    TextureRecord** link = find_link(texture);
+    if (*link) {
+        TextureRecord* record = *link;
+        *link = record->chain;
+
+        registry.stats.bytes -= record->bytes;
+        registry.stats.class_bytes[record->cls] -= record->bytes;
+        registry.stats.textures--;
+        free(record);
+    }
+
+    SDL_DestroyTexture(texture);
+}
+
+void texture_registry_set_reclaimer(TextureClass cls, TextureReclaimFunc reclaim, void* context) {
+    registry.reclaimers[cls] = reclaim;
+    registry.contexts[cls] = context;
+}
+
+void texture_registry_set_budget(size_t bytes) {
+    // Takes effect from the next texture created
+    registry.stats.budget = bytes;
+}
+
+void texture_registry_get_stats(TextureRegistryStats* stats) {
+    if (stats) *stats = registry.stats;
+}
+
+static bool make_room(TextureClass cls, size_t bytes) {
+    if (registry.stats.bytes + bytes <= registry.stats.budget || registry.reclaiming) {
+        return true;
+    }
+
+    // Quads already queued may use any texture about to be freed, whichever
+    // renderer the new one is for
+    render_batch_flush(NULL);
+
+    // Cheapest to rebuild first; a texture never pushes out a class that
+    // matters more than its own
+    registry.reclaiming = true;
+    for (int c = 0; c <= (int)cls && c < TEXTURE_CLASS_COUNT; c++) {
+        while (registry.stats.bytes + bytes > registry.stats.budget && registry.reclaimers[c]) {
+            size_t before = registry.stats.bytes;
+            size_t needed = registry.stats.bytes + bytes - registry.stats.budget;
+            if (!registry.reclaimers[c](registry.contexts[c], needed) ||
+                registry.stats.bytes >= before) {
+                break;
+            }
+            registry.stats.reclaimed += before - registry.stats.bytes;
+        }
+    }
+    registry.reclaiming = false;
+
+    if (registry.stats.bytes + bytes <= registry.stats.budget) return true;
+
+    // Logos fall back to placeholders and transitions to a cut
+    if (cls == TEXTURE_CLASS_TRANSITION || cls == TEXTURE_CLASS_THUMBNAIL) {
+        registry.stats.refused++;
+        return false;
+    }
+    return true;
+}
+
+static void track(SDL_Texture* texture, TextureClass cls) {
+    Uint32 format;
+    int w, h;
+    if (SDL_QueryTexture(texture, &format, NULL, &w, &h) != 0) return;
+
+    TextureRecord* record = malloc(sizeof(TextureRecord));
+    if (!record) return;
+
+    TextureRecord** bucket = bucket_of(texture);
+    record->texture = texture;
+    record->bytes = texture_bytes(format, w, h);
+    record->cls = cls;
+    record->chain = *bucket;
+    *bucket = record;
+
+    registry.stats.bytes += record->bytes;
+    registry.stats.class_bytes[cls] += record->bytes;
+    registry.stats.textures++;
+    if (registry.stats.bytes > registry.stats.peak) registry.stats.peak = registry.stats.bytes;
+}
+
+static size_t texture_bytes(Uint32 format, int w, int h) {
+    size_t pixels = (size_t)w * h;
+
+    // Planar YUV: full-size luma, two quarter-size chroma planes
+    switch (format) {
+        case SDL_PIXELFORMAT_YV12:
+        case SDL_PIXELFORMAT_IYUV:
+        case SDL_PIXELFORMAT_NV12:
+        case SDL_PIXELFORMAT_NV21:
+            return pixels + 2 * ((size_t)(w + 1) / 2) * ((size_t)(h + 1) / 2);
+        case SDL_PIXELFORMAT_YUY2:
+        case SDL_PIXELFORMAT_UYVY:
+        case SDL_PIXELFORMAT_YVYU:
+            return pixels * 2;
+        default:
+            return pixels * SDL_BYTESPERPIXEL(format);
+    }
+}
+
+static TextureRecord** find_link(SDL_Texture* texture) {
+    TextureRecord** link = bucket_of(texture);
+    while (*link && (*link)->texture != texture) {
+        link = &(*link)->chain;
+    }
+    return link;
+}
+
+static TextureRecord** bucket_of(SDL_Texture* texture) {
+    uint64_t hash = hash_bytes64(FNV64_OFFSET, &texture, sizeof(texture));
+    return &registry.buckets[hash & (TEXTURE_REGISTRY_BUCKETS - 1)];
+}
@@ -0,0 +1,51 @@
+#ifndef TEXTURE_REGISTRY_H
+#define TEXTURE_REGISTRY_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Owners of textures, from the first to be reclaimed to the last
+typedef enum {
+    TEXTURE_CLASS_TEXT,         // Cached shaped strings
+    TEXTURE_CLASS_TRANSITION,   // Screen captures for transitions
+    TEXTURE_CLASS_THUMBNAIL,    // Logo atlas pages
+    TEXTURE_CLASS_GLYPHS,       // Glyph atlases, never reclaimed
+    TEXTURE_CLASS_VIDEO,        // Player streaming texture, never reclaimed
+    TEXTURE_CLASS_COUNT
+} TextureClass;
+
+// Frees some cached textures of one class, at least bytes if it can;
+// returns false when nothing more can go
+typedef bool (*TextureReclaimFunc)(void* context, size_t bytes);
+
+// Texture registry counters
+typedef struct {
+    size_t bytes;                           // All live textures
+    size_t peak;
+    size_t budget;
+    size_t class_bytes[TEXTURE_CLASS_COUNT];
+    size_t textures;
+    Uint64 reclaimed;                       // Bytes released to stay in budget
+    Uint64 refused;                         // Textures not created for lack of room
+} TextureRegistryStats;
+
+// GPU texture registry
+//
+// Every texture the UI and player create goes through here, so their bytes
+// are known per class. When a new texture would exceed the budget, the
+// reclaim callbacks of the classes up to its own run in TextureClass order
+// until it fits. Queued batches are flushed first, so nothing freed is still
+// waiting to be drawn. Transitions and thumbnails have a fallback, so their
+// textures are refused when reclaiming is not enough; anything else is
+// created over budget.
+SDL_Texture* texture_registry_create(SDL_Renderer* renderer, TextureClass cls, Uint32 format,
+                                     int access, int w, int h);
+SDL_Texture* texture_registry_create_from_surface(SDL_Renderer* renderer, TextureClass cls,
+                                                  SDL_Surface* surface);
+void texture_registry_destroy(SDL_Texture* texture);
+void texture_registry_set_reclaimer(TextureClass cls, TextureReclaimFunc reclaim, void* context);
+void texture_registry_set_budget(size_t bytes);
+void texture_registry_get_stats(TextureRegistryStats* stats);
+
+#endif // TEXTURE_REGISTRY_H
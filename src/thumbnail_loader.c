@@ -0,0 +1,371 @@
+#include "thumbnail_loader.h"
+#include "thumbnail_store.h"
+#include "network.h"
+#include "ui_constants.h"
+#include <switch.h>
+#include <SDL2/SDL_image.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#define THUMBNAIL_CACHE_DIR "cache"
+#define THUMBNAIL_PACK_FILE THUMBNAIL_CACHE_DIR "/thumbnails.pack"
+#define THUMBNAIL_INDEX_FILE THUMBNAIL_CACHE_DIR "/thumbnails.idx"
+#define THUMBNAIL_ALIAS_FILE THUMBNAIL_CACHE_DIR "/thumbnails.alias"
+#define THUMBNAIL_MAX_AGE (7 * 24 * 3600)  // 1 week
+
+// Queued request, and later its decoded result
+typedef struct ThumbnailJob {
+    char* url;
+    SDL_Surface* surface;
+    uint64_t content;           // Hash of the surface pixels
+    struct ThumbnailJob* next;
+} ThumbnailJob;
+
+// FIFO of jobs
+typedef struct {
+    ThumbnailJob* head;
+    ThumbnailJob* tail;
+} ThumbnailQueue;
+
+struct ThumbnailLoader {
+    SDL_Thread** threads;
+    int thread_count;
+    SDL_mutex* lock;
+    SDL_cond* wake;
+    bool quit;
+    ThumbnailStore* store;
+
+    // All queues are guarded by lock
+    ThumbnailQueue pending;
+    ThumbnailQueue prefetch;    // Served only while pending is empty
+    ThumbnailQueue done;
+    Uint64 shared;              // Downloads the store already held, guarded by lock
+    ThumbnailStoreStats stats;  // Last stats read, UI thread only
+};
+
+static int thumbnail_loader_thread(void* arg);
+static SDL_Surface* load_surface(ThumbnailLoader* loader, const char* url, uint64_t* content);
+static SDL_Surface* scale_surface(SDL_Surface* source);
+static uint64_t url_key(const char* url);
+static uint64_t content_key(SDL_Surface* surface);
+static void queue_push(ThumbnailQueue* queue, ThumbnailJob* job);
+static ThumbnailJob* queue_pop(ThumbnailQueue* queue);
+static void queue_free(ThumbnailQueue* queue);
+
+ThumbnailLoader* thumbnail_loader_create(int worker_count) {
+    if (worker_count < 1) worker_count = 1;
+
+    ThumbnailLoader* loader = calloc(1, sizeof(ThumbnailLoader));
+    if (!loader) return NULL;
+
+    loader->threads = calloc(worker_count, sizeof(SDL_Thread*));
+    loader->lock = SDL_CreateMutex();
+    loader->wake = SDL_CreateCond();
+    if (!loader->threads || !loader->lock || !loader->wake) {
+        if (loader->wake) SDL_DestroyCond(loader->wake);
+        if (loader->lock) SDL_DestroyMutex(loader->lock);
+        free(loader->threads);
+        free(loader);
+        return NULL;
+    }
+
+    // Loads the pack index with one sequential read; without a store logos
+    // are simply downloaded every time
+    mkdir(THUMBNAIL_CACHE_DIR, 0755);
+    loader->store = thumbnail_store_open(THUMBNAIL_PACK_FILE, THUMBNAIL_INDEX_FILE,
+                                         THUMBNAIL_ALIAS_FILE);
+    thumbnail_store_set_budget(loader->store, THUMBNAIL_DISK_BUDGET);
+
+    for (int i = 0; i < worker_count; i++) {
+        loader->threads[i] = SDL_CreateThread(thumbnail_loader_thread, "thumbnail", loader);
+        if (!loader->threads[i]) break;
+        loader->thread_count++;
+    }
+
+    // A partial pool still works, just more slowly
+    if (loader->thread_count == 0) {
+        thumbnail_loader_free(loader);
+        return NULL;
+    }
+
+    return loader;
+}
+
+void thumbnail_loader_free(ThumbnailLoader* loader) {
+    if (!loader) return;
+
+    SDL_LockMutex(loader->lock);
+    loader->quit = true;
+    SDL_CondBroadcast(loader->wake);
+    SDL_UnlockMutex(loader->lock);
+
+    // Workers finish the download they are in the middle of, then exit
+    for (int i = 0; i < loader->thread_count; i++) {
+        SDL_WaitThread(loader->threads[i], NULL);
+    }
+
+    queue_free(&loader->pending);
+    queue_free(&loader->prefetch);
+    queue_free(&loader->done);
+    thumbnail_store_close(loader->store);
+    SDL_DestroyCond(loader->wake);
+    SDL_DestroyMutex(loader->lock);
+    free(loader->threads);
+    free(loader);
+}
+
+bool thumbnail_loader_submit(ThumbnailLoader* loader, const char* url, bool prefetch) {
+    if (!loader || !url || !url[0]) return false;
+
+    ThumbnailJob* job = calloc(1, sizeof(ThumbnailJob));
+    if (!job) return false;
+
+    job->url = strdup(url);
+    if (!job->url) {
+        free(job);
+        return false;
+    }
+
+    SDL_LockMutex(loader->lock);
+    queue_push(prefetch ? &loader->prefetch : &loader->pending, job);
+    SDL_CondSignal(loader->wake);
+    SDL_UnlockMutex(loader->lock);
+
+    return true;
+}
+
+bool thumbnail_loader_promote(ThumbnailLoader* loader, const char* url) {
+    if (!loader) return false;
+
+    SDL_LockMutex(loader->lock);
+
+    // The prefetch queue is a few pages long at most
+    ThumbnailJob* prev = NULL;
+    ThumbnailJob* job = loader->prefetch.head;
+    while (job && strcmp(job->url, url) != 0) {
+        prev = job;
+        job = job->next;
+    }
+
+    if (job) {
+        if (prev) prev->next = job->next;
+        else loader->prefetch.head = job->next;
+        if (loader->prefetch.tail == job) loader->prefetch.tail = prev;
+        queue_push(&loader->pending, job);
+    }
+
+    SDL_UnlockMutex(loader->lock);
+    return job != NULL;
+}
+
+void thumbnail_loader_cancel_prefetch(ThumbnailLoader* loader, ThumbnailCancelFunc cancelled,
+                                      void* context) {
+    if (!loader) return;
+
+    // Prefetches a worker already took are left to finish
+    SDL_LockMutex(loader->lock);
+    ThumbnailJob* job;
+    while ((job = queue_pop(&loader->prefetch))) {
+        if (cancelled) cancelled(context, job->url);
+        free(job->url);
+        free(job);
+    }
+    SDL_UnlockMutex(loader->lock);
+}
+
+void thumbnail_loader_get_stats(ThumbnailLoader* loader, ThumbnailStoreStats* stats) {
+    memset(stats, 0, sizeof(ThumbnailStoreStats));
+    if (!loader) return;
+
+    // Called every frame by the overlay; a busy lock keeps the last values
+    Uint64 shared = loader->stats.shared;
+    thumbnail_store_try_get_stats(loader->store, &loader->stats);
+    loader->stats.shared = shared;
+    if (SDL_TryLockMutex(loader->lock) == 0) {
+        loader->stats.shared = loader->shared;
+        SDL_UnlockMutex(loader->lock);
+    }
+    *stats = loader->stats;
+}
+
+bool thumbnail_loader_lookup(ThumbnailLoader* loader, const char* url, uint64_t* content) {
+    if (!loader || !url || !url[0]) return false;
+
+    // Runs on the UI thread, so a busy store counts as unknown
+    return thumbnail_store_try_alias(loader->store, url_key(url), content);
+}
+
+bool thumbnail_loader_poll(ThumbnailLoader* loader, char** url, SDL_Surface** surface,
+                           uint64_t* content) {
+    if (!loader) return false;
+
+    // Never stall the frame on a worker that holds the lock; retry next frame
+    if (SDL_TryLockMutex(loader->lock) != 0) return false;
+    ThumbnailJob* job = queue_pop(&loader->done);
+    SDL_UnlockMutex(loader->lock);
+
+    if (!job) return false;
+
+    // Ownership of both moves to the caller; surface is NULL on failure
+    *url = job->url;
+    *surface = job->surface;
+    *content = job->content;
+    free(job);
+    return true;
+}
+
+static int thumbnail_loader_thread(void* arg) {
+    ThumbnailLoader* loader = arg;
+
+    SDL_LockMutex(loader->lock);
+    while (!loader->quit) {
+        ThumbnailJob* job = queue_pop(&loader->pending);
+        if (!job) job = queue_pop(&loader->prefetch);
+        if (!job) {
+            SDL_CondWait(loader->wake, loader->lock);
+            continue;
+        }
+
+        SDL_UnlockMutex(loader->lock);
+        job->surface = load_surface(loader, job->url, &job->content);
+        SDL_LockMutex(loader->lock);
+
+        queue_push(&loader->done, job);
+    }
+    SDL_UnlockMutex(loader->lock);
+
+    return 0;
+}
+
+static SDL_Surface* load_surface(ThumbnailLoader* loader, const char* url, uint64_t* content) {
+    // Records are keyed by content, so every URL of the same logo shares
+    // one; the alias map leads from the URL to it
+    uint64_t alias = url_key(url);
+    uint64_t key = 0;
+    time_t stored = 0;
+    NetworkValidators validators;
+    SDL_Surface* cached = NULL;
+    if (thumbnail_store_alias(loader->store, alias, &key)) {
+        cached = thumbnail_store_read(loader->store, key, &stored, &validators);
+    } else {
+        memset(&validators, 0, sizeof(validators));
+    }
+
+    *content = key;
+    if (cached && time(NULL) - stored < THUMBNAIL_MAX_AGE) {
+        return cached;
+    }
+
+    // A stale logo is revalidated; a 304 keeps it without any body transfer.
+    // The validators are those of whichever URL stored the record, so
+    // another host simply answers with the full logo
+    NetworkBuffer* buffer = NULL;
+    long status = network_download_revalidate(url, &validators, &buffer);
+    if (status == 304 && cached) {
+        thumbnail_store_touch(loader->store, key, &validators);
+        return cached;
+    }
+
+    SDL_Surface* surface = NULL;
+    if (buffer) {
+        SDL_RWops* rw = SDL_RWFromConstMem(buffer->data, (int)buffer->size);
+        surface = rw ? IMG_Load_RW(rw, 1) : NULL;
+        network_buffer_free(buffer);
+    }
+
+    // Keep showing a stale logo while its host is unreachable
+    if (!surface) return cached;
+    if (cached) SDL_FreeSurface(cached);
+
+    SDL_Surface* scaled = scale_surface(surface);
+    SDL_FreeSurface(surface);
+    if (!scaled) return NULL;
+
+    // A logo the store already holds under another URL only gains an alias
+    key = content_key(scaled);
+    if (thumbnail_store_contains(loader->store, key)) {
+        SDL_LockMutex(loader->lock);
+        loader->shared++;
+        SDL_UnlockMutex(loader->lock);
+    } else {
+        thumbnail_store_write(loader->store, key, scaled, &validators);
+    }
+    thumbnail_store_set_alias(loader->store, alias, key);
+
+    *content = key;
+    return scaled;
+}
+
+static SDL_Surface* scale_surface(SDL_Surface* source) {
+    // Fit inside a tile, keeping the aspect ratio; never scale up
+    float scale = MIN((float)THUMBNAIL_WIDTH / source->w, (float)THUMBNAIL_HEIGHT / source->h);
+    if (scale > 1.0f) scale = 1.0f;
+
+    int w = MAX(1, (int)(source->w * scale));
+    int h = MAX(1, (int)(source->h * scale));
+
+    // Linear stretching needs both sides in the same format
+    SDL_Surface* rgba = SDL_ConvertSurfaceFormat(source, SDL_PIXELFORMAT_RGBA32, 0);
+    if (!rgba) return NULL;
+    if (w == rgba->w && h == rgba->h) return rgba;
+
+    SDL_Surface* scaled = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_RGBA32);
+    if (scaled && SDL_SoftStretchLinear(rgba, NULL, scaled, NULL) != 0) {
+        SDL_FreeSurface(scaled);
+        scaled = NULL;
+    }
+    SDL_FreeSurface(rgba);
+    return scaled;
+}
+
+static uint64_t url_key(const char* url) {
+    // A SHA-256 of the whole URL: the last path segment alone ("logo.png")
+    // collides across hosts
+    u8 digest[SHA256_HASH_SIZE];
+    uint64_t key;
+    sha256CalculateHash(digest, url, strlen(url));
+    memcpy(&key, digest, sizeof(key));
+    return key;
+}
+
+static uint64_t content_key(SDL_Surface* surface) {
+    // Size goes in first so differently shaped logos with the same bytes
+    // never match; scaled surfaces have no row padding
+    u8 digest[SHA256_HASH_SIZE];
+    uint16_t size[2] = {(uint16_t)surface->w, (uint16_t)surface->h};
+    uint64_t key;
+    Sha256Context context;
+    sha256ContextCreate(&context);
+    sha256ContextUpdate(&context, size, sizeof(size));
+    sha256ContextUpdate(&context, surface->pixels, (size_t)surface->pitch * surface->h);
+    sha256ContextGetHash(&context, digest);
+    memcpy(&key, digest, sizeof(key));
+    return key;
+}
+
+static void queue_push(ThumbnailQueue* queue, ThumbnailJob* job) {
+    job->next = NULL;
+    if (queue->tail) queue->tail->next = job;
+    else queue->head = job;
+    queue->tail = job;
+}
+
+static ThumbnailJob* queue_pop(ThumbnailQueue* queue) {
+    ThumbnailJob* job = queue->head;
+    if (!job) return NULL;
+
+    queue->head = job->next;
+    if (!queue->head) queue->tail = NULL;
+    return job;
+}
+
+static void queue_free(ThumbnailQueue* queue) {
+    ThumbnailJob* job;
+    while ((job = queue_pop(queue))) {
+        if (job->surface) SDL_FreeSurface(job->surface);
+        free(job->url);
+        free(job);
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef THUMBNAIL_LOADER_H
+#define THUMBNAIL_LOADER_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "thumbnail_store.h"
+
+struct ThumbnailLoader;
+typedef struct ThumbnailLoader ThumbnailLoader;
+
+// Called for each prefetch dropped from the queue
+typedef void (*ThumbnailCancelFunc)(void* context, const char* url);
+
+// Background thumbnail loader
+//
+// A small pool of worker threads serves logos from the thumbnail store as
+// RGBA32 surfaces no larger than a thumbnail tile, downloading and
+// prescaling the ones that are missing or out of date.
+// Requests are served first in, first out and finished surfaces wait in a
+// completion queue until the UI thread collects them with
+// thumbnail_loader_poll, which never blocks. Uploading to the GPU is left to
+// the caller, since only the render thread may touch the renderer.
+//
+// Each result carries a hash of its pixels, so the caller can share one
+// texture between URLs serving the same logo. thumbnail_loader_lookup
+// returns that hash without a worker when the URL has been seen before.
+// thumbnail_loader_get_stats never blocks either; while a worker or the
+// compactor holds a lock it returns the last stats it read.
+//
+// Prefetches wait in a separate low-priority queue that workers only serve
+// when no visible logo is waiting. Until a worker picks one up it can be
+// promoted to the normal queue or cancelled.
+ThumbnailLoader* thumbnail_loader_create(int worker_count);
+void thumbnail_loader_free(ThumbnailLoader* loader);
+bool thumbnail_loader_submit(ThumbnailLoader* loader, const char* url, bool prefetch);
+bool thumbnail_loader_promote(ThumbnailLoader* loader, const char* url);
+void thumbnail_loader_cancel_prefetch(ThumbnailLoader* loader, ThumbnailCancelFunc cancelled,
+                                      void* context);
+bool thumbnail_loader_lookup(ThumbnailLoader* loader, const char* url, uint64_t* content);
+bool thumbnail_loader_poll(ThumbnailLoader* loader, char** url, SDL_Surface** surface,
+                           uint64_t* content);
+void thumbnail_loader_get_stats(ThumbnailLoader* loader, ThumbnailStoreStats* stats);
+
+#endif // THUMBNAIL_LOADER_H
@@ -0,0 +1,920 @@
+#include "thumbnail_store.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#define STORE_RECORD_MAGIC 0x334B5054u   // "TPK3"
+#define STORE_INDEX_MAGIC 0x33584449u    // "IDX3"
+#define STORE_ALIAS_MAGIC 0x31534C41u    // "ALS1"
+#define STORE_INITIAL_SLOTS 1024
+#define STORE_MIN_GARBAGE (1024 * 1024)  // Bytes before compaction is worth it
+#define STORE_INDEX_INTERVAL 64          // Index changes between index writes
+
+// Header in front of every compressed logo in the pack
+typedef struct {
+    uint32_t magic;
+    uint32_t size;      // Payload bytes that follow: validators, then pixels
+    uint64_t key;
+    int64_t stored;     // When the logo was downloaded
+    uint16_t w;
+    uint16_t h;
+    uint16_t etag_length;
+    uint16_t modified_length;
+} StoreRecord;
+
+// Index file header, followed by count StoreEntry
+typedef struct {
+    uint32_t magic;
+    uint32_t count;
+    uint64_t covered;   // Pack bytes the entries describe
+} StoreIndexHeader;
+
+// Latest record of a key
+typedef struct {
+    uint64_t key;
+    uint64_t offset;    // Record header within the pack
+    uint32_t size;
+    uint16_t w;
+    uint16_t h;
+    int64_t stored;     // Downloaded or last revalidated
+    int64_t used;       // Access clock of the last read, for eviction
+    uint16_t etag_length;
+    uint16_t modified_length;
+    uint32_t reserved;
+} StoreEntry;
+
+// Alias file header, followed by StoreAlias pairs; later pairs win
+typedef struct {
+    uint32_t magic;
+    uint32_t reserved;
+} StoreAliasHeader;
+
+// Content key of the logo a URL key serves
+typedef struct {
+    uint64_t url_key;   // 0 marks an empty slot
+    uint64_t content;
+} StoreAlias;
+
+// Eviction candidate
+typedef struct {
+    int64_t used;
+    uint32_t index;
+} StoreAge;
+
+struct ThumbnailStore {
+    SDL_mutex* lock;
+    FILE* pack;
+    char* pack_path;
+    char* index_path;
+    uint64_t pack_size;
+    uint64_t live_bytes;    // Bytes of records still referenced by entries
+    uint64_t budget;        // Live bytes allowed before eviction
+    int64_t clock;          // Ticks on every read and write; persisted via used
+    size_t index_changes;   // Appends and revalidations since the index was written
+    ThumbnailStoreStats stats;
+
+    StoreEntry* entries;
+    size_t count;
+    size_t capacity;
+    uint32_t* slots;        // Entry index + 1, 0 when empty
+    size_t slot_count;
+
+    StoreAlias* aliases;    // Open addressing on url_key
+    size_t alias_count;
+    size_t alias_slot_count;
+    FILE* alias_file;       // Appended to as aliases are learned
+    char* alias_path;
+    size_t alias_records;   // Pairs in the file, including overwritten ones
+
+    SDL_Thread* compactor;
+    bool compacting;
+};
+
+static uint64_t load_index(ThumbnailStore* store);
+static void scan_pack(ThumbnailStore* store, uint64_t offset);
+static bool write_index(ThumbnailStore* store);
+static void index_changed(ThumbnailStore* store);
+static StoreEntry* find_entry(ThumbnailStore* store, uint64_t key);
+static bool insert_entry(ThumbnailStore* store, const StoreEntry* entry);
+static bool grow_slots(ThumbnailStore* store);
+static bool rebuild_slots(ThumbnailStore* store, size_t slot_count);
+static void reset_entries(ThumbnailStore* store);
+static void load_aliases(ThumbnailStore* store);
+static bool write_aliases(ThumbnailStore* store);
+static StoreAlias* find_alias(ThumbnailStore* store, uint64_t url_key);
+static bool insert_alias(ThumbnailStore* store, uint64_t url_key, uint64_t content);
+static void update_validators(ThumbnailStore* store, StoreEntry* entry,
+                              const NetworkValidators* validators);
+static void evict_to_budget(ThumbnailStore* store, uint64_t keep);
+static int compare_age(const void* a, const void* b);
+static void maybe_compact(ThumbnailStore* store);
+static int compact_thread(void* arg);
+static bool copy_record(FILE* from, FILE* to, uint64_t offset, uint32_t size);
+static char* path_with_suffix(const char* path, const char* suffix);
+
+static inline uint64_t record_bytes(uint32_t size) {
+    return sizeof(StoreRecord) + (uint64_t)size;
+}
+
+ThumbnailStore* thumbnail_store_open(const char* pack_path, const char* index_path,
+                                     const char* alias_path) {
+    ThumbnailStore* store = calloc(1, sizeof(ThumbnailStore));
+    if (!store) return NULL;
+
+    store->pack_path = strdup(pack_path);
+    store->index_path = strdup(index_path);
+    store->alias_path = strdup(alias_path);
+    store->lock = SDL_CreateMutex();
+    store->budget = UINT64_MAX;
+
+    store->pack = fopen(pack_path, "r+b");
+    if (!store->pack) store->pack = fopen(pack_path, "w+b");
+
+    if (!store->pack_path || !store->index_path || !store->alias_path || !store->lock ||
+        !store->pack || !grow_slots(store)) {
+        thumbnail_store_close(store);
+        return NULL;
+    }
+
+    fseek(store->pack, 0, SEEK_END);
+    long size = ftell(store->pack);
+    store->pack_size = size > 0 ? (uint64_t)size : 0;
+
+    // The index covers everything up to its last write; anything appended
+    // later is picked up from the record headers
+    scan_pack(store, load_index(store));
+    load_aliases(store);
+
+    return store;
+}
+
+void thumbnail_store_close(ThumbnailStore* store) {
+    if (!store) return;
+
+    // The compactor takes the lock itself; wait for it outside
+    if (store->compactor) SDL_WaitThread(store->compactor, NULL);
+
+    if (store->pack) {
+        write_index(store);
+        fclose(store->pack);
+    }
+
+    // Aliases of evicted logos and overwritten pairs are dropped here
+    if (store->alias_file) {
+        fclose(store->alias_file);
+        write_aliases(store);
+    }
+
+    if (store->lock) SDL_DestroyMutex(store->lock);
+    free(store->entries);
+    free(store->slots);
+    free(store->aliases);
+    free(store->pack_path);
+    free(store->index_path);
+    free(store->alias_path);
+    free(store);
+}
+
+SDL_Surface* thumbnail_store_read(ThumbnailStore* store, uint64_t key, time_t* stored,
+                                  NetworkValidators* validators) {
+    if (validators) memset(validators, 0, sizeof(NetworkValidators));
+    if (!store) return NULL;
+
+    SDL_LockMutex(store->lock);
+
+    StoreEntry* found = find_entry(store, key);
+    StoreEntry entry;
+    unsigned char* data = NULL;
+    if (found) store->stats.hits++;
+    else store->stats.misses++;
+
+    if (found && store->pack) {
+        found->used = ++store->clock;
+        entry = *found;
+        data = malloc(entry.size);
+        if (data && (fseek(store->pack, (long)(entry.offset + sizeof(StoreRecord)), SEEK_SET) != 0 ||
+                     fread(data, entry.size, 1, store->pack) != 1)) {
+            free(data);
+            data = NULL;
+        }
+    }
+
+    SDL_UnlockMutex(store->lock);
+
+    if (!data) return NULL;
+
+    uint32_t header = entry.etag_length + entry.modified_length;
+    if (validators && entry.etag_length < sizeof(validators->etag) &&
+        entry.modified_length < sizeof(validators->last_modified)) {
+        memcpy(validators->etag, data, entry.etag_length);
+        memcpy(validators->last_modified, data + entry.etag_length, entry.modified_length);
+    }
+
+    // Decompress outside the lock so other workers can read meanwhile
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, entry.w, entry.h, 32,
+                                                          SDL_PIXELFORMAT_RGBA32);
+    if (surface) {
+        uLongf length = (uLongf)surface->pitch * surface->h;
+        if (surface->pitch != entry.w * 4 || header > entry.size ||
+            uncompress(surface->pixels, &length, data + header, entry.size - header) != Z_OK ||
+            length != (uLongf)surface->pitch * surface->h) {
+            SDL_FreeSurface(surface);
+            surface = NULL;
+        }
+    }
+    free(data);
+
+    if (surface && stored) *stored = (time_t)entry.stored;
+    if (!surface && validators) memset(validators, 0, sizeof(NetworkValidators));
+    return surface;
+}
+
+bool thumbnail_store_write(ThumbnailStore* store, uint64_t key, SDL_Surface* surface,
+                           const NetworkValidators* validators) {
+    if (!store || !surface || surface->format->format != SDL_PIXELFORMAT_RGBA32) return false;
+    if (surface->pitch != surface->w * 4 || surface->w > UINT16_MAX || surface->h > UINT16_MAX) {
+        return false;
+    }
+
+    size_t etag_length = validators ? strlen(validators->etag) : 0;
+    size_t modified_length = validators ? strlen(validators->last_modified) : 0;
+    size_t header = etag_length + modified_length;
+
+    uLong raw = (uLong)surface->pitch * surface->h;
+    uLongf length = compressBound(raw);
+    unsigned char* data = malloc(header + length);
+    if (!data) return false;
+
+    // Validators go in front of the pixels so one read returns both
+    if (validators) {
+        memcpy(data, validators->etag, etag_length);
+        memcpy(data + etag_length, validators->last_modified, modified_length);
+    }
+
+    if (compress2(data + header, &length, surface->pixels, raw, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        free(data);
+        return false;
+    }
+    length += header;
+
+    StoreRecord record = {
+        .magic = STORE_RECORD_MAGIC,
+        .size = (uint32_t)length,
+        .key = key,
+        .stored = (int64_t)time(NULL),
+        .w = (uint16_t)surface->w,
+        .h = (uint16_t)surface->h,
+        .etag_length = (uint16_t)etag_length,
+        .modified_length = (uint16_t)modified_length
+    };
+
+    SDL_LockMutex(store->lock);
+
+    // A failed append leaves pack_size alone, so the next one overwrites it
+    bool ok = store->pack &&
+              fseek(store->pack, (long)store->pack_size, SEEK_SET) == 0 &&
+              fwrite(&record, sizeof(record), 1, store->pack) == 1 &&
+              fwrite(data, length, 1, store->pack) == 1 &&
+              fflush(store->pack) == 0;
+
+    if (ok) {
+        StoreEntry entry = {
+            .key = key,
+            .offset = store->pack_size,
+            .size = record.size,
+            .w = record.w,
+            .h = record.h,
+            .stored = record.stored,
+            .used = ++store->clock,
+            .etag_length = record.etag_length,
+            .modified_length = record.modified_length
+        };
+        if (find_entry(store, key)) store->stats.refreshed++;
+        store->pack_size += record_bytes(record.size);
+        ok = insert_entry(store, &entry);
+        evict_to_budget(store, key);
+        maybe_compact(store);
+        index_changed(store);
+    }
+
+    SDL_UnlockMutex(store->lock);
+
+    free(data);
+    return ok;
+}
+
+bool thumbnail_store_touch(ThumbnailStore* store, uint64_t key,
+                           const NetworkValidators* validators) {
+    if (!store) return false;
+
+    // The logo is unchanged; unless its validators moved on, only the index
+    // is updated
+    SDL_LockMutex(store->lock);
+    StoreEntry* entry = find_entry(store, key);
+    if (entry) {
+        entry->stored = (int64_t)time(NULL);
+        store->stats.revalidated++;
+        if (validators) update_validators(store, entry, validators);
+        index_changed(store);
+    }
+    SDL_UnlockMutex(store->lock);
+    return entry != NULL;
+}
+
+bool thumbnail_store_contains(ThumbnailStore* store, uint64_t key) {
+    if (!store) return false;
+
+    // A lookup only: the record keeps its age, validators and counters
+    SDL_LockMutex(store->lock);
+    bool found = find_entry(store, key) != NULL;
+    SDL_UnlockMutex(store->lock);
+    return found;
+}
+
+bool thumbnail_store_alias(ThumbnailStore* store, uint64_t url_key, uint64_t* content) {
+    if (!store) return false;
+
+    SDL_LockMutex(store->lock);
+    StoreAlias* alias = find_alias(store, url_key);
+    if (alias) *content = alias->content;
+    SDL_UnlockMutex(store->lock);
+    return alias != NULL;
+}
+
+bool thumbnail_store_try_alias(ThumbnailStore* store, uint64_t url_key, uint64_t* content) {
+    if (!store || SDL_TryLockMutex(store->lock) != 0) return false;
+
+    StoreAlias* alias = find_alias(store, url_key);
+    if (alias) *content = alias->content;
+    SDL_UnlockMutex(store->lock);
+    return alias != NULL;
+}
+
+void thumbnail_store_set_alias(ThumbnailStore* store, uint64_t url_key, uint64_t content) {
+    if (!store) return;
+
+    SDL_LockMutex(store->lock);
+
+    StoreAlias* alias = find_alias(store, url_key);
+    if (!alias || alias->content != content) {
+        // The pair only has to reach the file before the next open; a lost
+        // one costs a download
+        StoreAlias pair = {url_key ? url_key : 1, content};
+        if (insert_alias(store, url_key, content) && store->alias_file &&
+            fwrite(&pair, sizeof(pair), 1, store->alias_file) == 1) {
+            fflush(store->alias_file);
+            store->alias_records++;
+        }
+    }
+
+    SDL_UnlockMutex(store->lock);
+}
+
+void thumbnail_store_set_budget(ThumbnailStore* store, uint64_t bytes) {
+    if (!store) return;
+
+    SDL_LockMutex(store->lock);
+    store->budget = bytes;
+    evict_to_budget(store, 0);
+    maybe_compact(store);
+    SDL_UnlockMutex(store->lock);
+}
+
+void thumbnail_store_get_stats(ThumbnailStore* store, ThumbnailStoreStats* stats) {
+    if (!store || !stats) return;
+
+    SDL_LockMutex(store->lock);
+    *stats = store->stats;
+    stats->bytes = store->live_bytes;
+    stats->entries = store->count;
+    stats->aliases = store->alias_count;
+    SDL_UnlockMutex(store->lock);
+}
+
+bool thumbnail_store_try_get_stats(ThumbnailStore* store, ThumbnailStoreStats* stats) {
+    if (!store || !stats || SDL_TryLockMutex(store->lock) != 0) return false;
+
+    *stats = store->stats;
+    stats->bytes = store->live_bytes;
+    stats->entries = store->count;
+    stats->aliases = store->alias_count;
+    SDL_UnlockMutex(store->lock);
+    return true;
+}
+
+static uint64_t load_index(ThumbnailStore* store) {
+    FILE* fp = fopen(store->index_path, "rb");
+    if (!fp) return 0;
+
+    StoreIndexHeader header;
+    StoreEntry* entries = NULL;
+    bool ok = fread(&header, sizeof(header), 1, fp) == 1 &&
+              header.magic == STORE_INDEX_MAGIC &&
+              header.covered <= store->pack_size;
+
+    // One sequential read for the whole index
+    if (ok && header.count > 0) {
+        entries = malloc(header.count * sizeof(StoreEntry));
+        ok = entries && fread(entries, sizeof(StoreEntry), header.count, fp) == header.count;
+    }
+    fclose(fp);
+
+    for (uint32_t i = 0; ok && i < header.count; i++) {
+        ok = entries[i].offset + record_bytes(entries[i].size) <= header.covered &&
+             insert_entry(store, &entries[i]);
+    }
+    free(entries);
+
+    // A stale or damaged index is dropped and the pack scanned from the start
+    if (!ok) {
+        reset_entries(store);
+        return 0;
+    }
+    return header.covered;
+}
+
+static void scan_pack(ThumbnailStore* store, uint64_t offset) {
+    StoreRecord record;
+
+    while (offset + sizeof(record) <= store->pack_size &&
+           fseek(store->pack, (long)offset, SEEK_SET) == 0 &&
+           fread(&record, sizeof(record), 1, store->pack) == 1 &&
+           record.magic == STORE_RECORD_MAGIC &&
+           offset + record_bytes(record.size) <= store->pack_size) {
+        StoreEntry entry = {
+            .key = record.key,
+            .offset = offset,
+            .size = record.size,
+            .w = record.w,
+            .h = record.h,
+            .stored = record.stored,
+            .used = ++store->clock,
+            .etag_length = record.etag_length,
+            .modified_length = record.modified_length
+        };
+        if (!insert_entry(store, &entry)) break;
+        offset += record_bytes(record.size);
+    }
+
+    // A torn append at the end is overwritten by the next write
+    store->pack_size = offset;
+}
+
+static bool write_index(ThumbnailStore* store) {
+    char* temp_path = path_with_suffix(store->index_path, ".tmp");
+    if (!temp_path) return false;
+
+    StoreIndexHeader header = {
+        .magic = STORE_INDEX_MAGIC,
+        .count = (uint32_t)store->count,
+        .covered = store->pack_size
+    };
+
+    FILE* fp = fopen(temp_path, "wb");
+    bool ok = fp &&
+              fwrite(&header, sizeof(header), 1, fp) == 1 &&
+              fwrite(store->entries, sizeof(StoreEntry), store->count, fp) == store->count;
+    if (fp && fclose(fp) != 0) ok = false;
+
+    // FAT cannot rename over an existing file
+    if (ok) {
+        remove(store->index_path);
+        ok = rename(temp_path, store->index_path) == 0;
+    } else {
+        remove(temp_path);
+    }
+
+    free(temp_path);
+    if (ok) store->index_changes = 0;
+    return ok;
+}
+
+static void index_changed(ThumbnailStore* store) {
+    // The app may never get to close the store, and every record past the
+    // index costs a seek and a read on the next open
+    if (++store->index_changes < STORE_INDEX_INTERVAL) return;
+
+    // A failed write waits for the next interval rather than the next change
+    if (!write_index(store)) store->index_changes = 0;
+}
+
+static StoreEntry* find_entry(ThumbnailStore* store, uint64_t key) {
+    size_t mask = store->slot_count - 1;
+    for (size_t slot = key & mask; store->slots[slot]; slot = (slot + 1) & mask) {
+        StoreEntry* entry = &store->entries[store->slots[slot] - 1];
+        if (entry->key == key) return entry;
+    }
+    return NULL;
+}
+
+static bool insert_entry(ThumbnailStore* store, const StoreEntry* entry) {
+    if (entry->used > store->clock) store->clock = entry->used;
+
+    // A newer record of the same key turns the old one into garbage
+    StoreEntry* existing = find_entry(store, entry->key);
+    if (existing) {
+        store->live_bytes -= record_bytes(existing->size);
+        *existing = *entry;
+        store->live_bytes += record_bytes(entry->size);
+        return true;
+    }
+
+    if (store->count == store->capacity) {
+        size_t capacity = store->capacity ? store->capacity * 2 : STORE_INITIAL_SLOTS / 2;
+        StoreEntry* entries = realloc(store->entries, capacity * sizeof(StoreEntry));
+        if (!entries) return false;
+        store->entries = entries;
+        store->capacity = capacity;
+    }
+
+    // Keep the table at most half full
+    if ((store->count + 1) * 2 > store->slot_count && !grow_slots(store)) return false;
+
+    store->entries[store->count] = *entry;
+    store->count++;
+    store->live_bytes += record_bytes(entry->size);
+
+    size_t mask = store->slot_count - 1;
+    size_t slot = entry->key & mask;
+    while (store->slots[slot]) {
+        slot = (slot + 1) & mask;
+    }
+    store->slots[slot] = (uint32_t)store->count;
+    return true;
+}
+
+static bool grow_slots(ThumbnailStore* store) {
+    return rebuild_slots(store, store->slot_count ? store->slot_count * 2 : STORE_INITIAL_SLOTS);
+}
+
+static bool rebuild_slots(ThumbnailStore* store, size_t slot_count) {
+    uint32_t* slots = calloc(slot_count, sizeof(uint32_t));
+    if (!slots) return false;
+
+    size_t mask = slot_count - 1;
+    for (size_t i = 0; i < store->count; i++) {
+        size_t slot = store->entries[i].key & mask;
+        while (slots[slot]) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = (uint32_t)(i + 1);
+    }
+
+    free(store->slots);
+    store->slots = slots;
+    store->slot_count = slot_count;
+    return true;
+}
+
+static void reset_entries(ThumbnailStore* store) {
+    store->count = 0;
+    store->live_bytes = 0;
+    memset(store->slots, 0, store->slot_count * sizeof(uint32_t));
+}
+
+static void load_aliases(ThumbnailStore* store) {
+    FILE* fp = fopen(store->alias_path, "rb");
+    StoreAliasHeader header;
+    StoreAlias* pairs = NULL;
+    size_t count = 0;
+
+    // One sequential read for the whole file, like the index
+    if (fp && fread(&header, sizeof(header), 1, fp) == 1 && header.magic == STORE_ALIAS_MAGIC &&
+        fseek(fp, 0, SEEK_END) == 0) {
+        long size = ftell(fp);
+        count = size > (long)sizeof(header) ? (size - sizeof(header)) / sizeof(StoreAlias) : 0;
+        pairs = count ? malloc(count * sizeof(StoreAlias)) : NULL;
+        if (!pairs || fseek(fp, sizeof(header), SEEK_SET) != 0) count = 0;
+        count = count ? fread(pairs, sizeof(StoreAlias), count, fp) : 0;
+    }
+    if (fp) fclose(fp);
+
+    for (size_t i = 0; i < count; i++) {
+        insert_alias(store, pairs[i].url_key, pairs[i].content);
+    }
+    free(pairs);
+
+    // A missing or damaged file starts over; a torn last pair is dropped
+    // by rewriting what was read
+    if (count > 0 && write_aliases(store)) {
+        store->alias_file = fopen(store->alias_path, "ab");
+    } else {
+        header.magic = STORE_ALIAS_MAGIC;
+        header.reserved = 0;
+        store->alias_file = fopen(store->alias_path, "wb");
+        if (store->alias_file && (fwrite(&header, sizeof(header), 1, store->alias_file) != 1 ||
+                                  fflush(store->alias_file) != 0)) {
+            fclose(store->alias_file);
+            store->alias_file = NULL;
+        }
+        store->alias_records = 0;
+    }
+}
+
+static bool write_aliases(ThumbnailStore* store) {
+    char* temp_path = path_with_suffix(store->alias_path, ".tmp");
+    if (!temp_path) return false;
+
+    StoreAliasHeader header = {
+        .magic = STORE_ALIAS_MAGIC,
+        .reserved = 0
+    };
+
+    // Aliases whose logo has been evicted would only lead to a miss
+    FILE* fp = fopen(temp_path, "wb");
+    bool ok = fp && fwrite(&header, sizeof(header), 1, fp) == 1;
+    size_t written = 0;
+    for (size_t i = 0; ok && i < store->alias_slot_count; i++) {
+        StoreAlias* alias = &store->aliases[i];
+        if (!alias->url_key || !find_entry(store, alias->content)) continue;
+
+        ok = fwrite(alias, sizeof(StoreAlias), 1, fp) == 1;
+        written++;
+    }
+    if (fp && fclose(fp) != 0) ok = false;
+
+    // FAT cannot rename over an existing file
+    if (ok) {
+        remove(store->alias_path);
+        ok = rename(temp_path, store->alias_path) == 0;
+    } else {
+        remove(temp_path);
+    }
+
+    if (ok) store->alias_records = written;
+    free(temp_path);
+    return ok;
+}
+
+static StoreAlias* find_alias(ThumbnailStore* store, uint64_t url_key) {
+    if (!store->aliases) return NULL;
+    if (!url_key) url_key = 1;
+
+    size_t mask = store->alias_slot_count - 1;
+    for (size_t slot = url_key & mask; store->aliases[slot].url_key; slot = (slot + 1) & mask) {
+        if (store->aliases[slot].url_key == url_key) return &store->aliases[slot];
+    }
+    return NULL;
+}
+
+static bool insert_alias(ThumbnailStore* store, uint64_t url_key, uint64_t content) {
+    if (!url_key) url_key = 1;
+
+    StoreAlias* existing = find_alias(store, url_key);
+    if (existing) {
+        existing->content = content;
+        return true;
+    }
+
+    // Keep the table at most half full
+    if ((store->alias_count + 1) * 2 > store->alias_slot_count) {
+        size_t slot_count = store->alias_slot_count ? store->alias_slot_count * 2
+                                                    : STORE_INITIAL_SLOTS;
+        StoreAlias* aliases = calloc(slot_count, sizeof(StoreAlias));
+        if (!aliases) return false;
+
+        size_t mask = slot_count - 1;
+        for (size_t i = 0; i < store->alias_slot_count; i++) {
+            if (!store->aliases[i].url_key) continue;
+            size_t slot = store->aliases[i].url_key & mask;
+            while (aliases[slot].url_key) {
+                slot = (slot + 1) & mask;
+            }
+            aliases[slot] = store->aliases[i];
+        }
+
+        free(store->aliases);
+        store->aliases = aliases;
+        store->alias_slot_count = slot_count;
+    }
+
+    size_t mask = store->alias_slot_count - 1;
+    size_t slot = url_key & mask;
+    while (store->aliases[slot].url_key) {
+        slot = (slot + 1) & mask;
+    }
+    store->aliases[slot].url_key = url_key;
+    store->aliases[slot].content = content;
+    store->alias_count++;
+    return true;
+}
+
+static void update_validators(ThumbnailStore* store, StoreEntry* entry,
+                              const NetworkValidators* validators) {
+    size_t etag_length = strlen(validators->etag);
+    size_t modified_length = strlen(validators->last_modified);
+    uint32_t old_header = entry->etag_length + entry->modified_length;
+    uint32_t header = (uint32_t)(etag_length + modified_length);
+    if (!store->pack || old_header > entry->size) return;
+
+    // Read the old payload with room for the new validators in front
+    uint32_t pixels = entry->size - old_header;
+    unsigned char* data = malloc((size_t)header + entry->size);
+    if (!data) return;
+    unsigned char* old = data + header;
+    if (fseek(store->pack, (long)(entry->offset + sizeof(StoreRecord)), SEEK_SET) != 0 ||
+        fread(old, entry->size, 1, store->pack) != 1 ||
+        (etag_length == entry->etag_length && modified_length == entry->modified_length &&
+         memcmp(old, validators->etag, etag_length) == 0 &&
+         memcmp(old + etag_length, validators->last_modified, modified_length) == 0)) {
+        free(data);
+        return;
+    }
+
+    // Validators live in the record, so it is appended again around the
+    // same compressed pixels; the old copy becomes garbage
+    memmove(data + header, old + old_header, pixels);
+    memcpy(data, validators->etag, etag_length);
+    memcpy(data + etag_length, validators->last_modified, modified_length);
+
+    StoreRecord record = {
+        .magic = STORE_RECORD_MAGIC,
+        .size = header + pixels,
+        .key = entry->key,
+        .stored = entry->stored,
+        .w = entry->w,
+        .h = entry->h,
+        .etag_length = (uint16_t)etag_length,
+        .modified_length = (uint16_t)modified_length
+    };
+    bool ok = fseek(store->pack, (long)store->pack_size, SEEK_SET) == 0 &&
+              fwrite(&record, sizeof(record), 1, store->pack) == 1 &&
+              fwrite(data, record.size, 1, store->pack) == 1 &&
+              fflush(store->pack) == 0;
+    free(data);
+    if (!ok) return;
+
+    store->live_bytes -= record_bytes(entry->size);
+    entry->offset = store->pack_size;
+    entry->size = record.size;
+    entry->etag_length = record.etag_length;
+    entry->modified_length = record.modified_length;
+    store->pack_size += record_bytes(record.size);
+    store->live_bytes += record_bytes(record.size);
+    maybe_compact(store);
+}
+
+static void evict_to_budget(ThumbnailStore* store, uint64_t keep) {
+    // Entry indices must stay put while the compactor maps them; the next
+    // write after it finishes catches up
+    if (store->live_bytes <= store->budget || store->compacting) return;
+
+    StoreAge* ages = malloc(store->count * sizeof(StoreAge));
+    if (!ages) return;
+
+    for (size_t i = 0; i < store->count; i++) {
+        ages[i].used = store->entries[i].used;
+        ages[i].index = (uint32_t)i;
+    }
+    qsort(ages, store->count, sizeof(StoreAge), compare_age);
+
+    // Evict down to 7/8 of the budget so the next few writes do not each
+    // trigger another sort
+    uint64_t target = store->budget - store->budget / 8;
+    for (size_t i = 0; i < store->count && store->live_bytes > target; i++) {
+        StoreEntry* entry = &store->entries[ages[i].index];
+        if (entry->key == keep) continue;
+
+        store->live_bytes -= record_bytes(entry->size);
+        entry->size = UINT32_MAX;
+        store->stats.evictions++;
+    }
+    free(ages);
+
+    // Drop the evicted entries; their records become garbage
+    size_t count = 0;
+    for (size_t i = 0; i < store->count; i++) {
+        if (store->entries[i].size != UINT32_MAX) {
+            store->entries[count++] = store->entries[i];
+        }
+    }
+    store->count = count;
+    rebuild_slots(store, store->slot_count);
+}
+
+static int compare_age(const void* a, const void* b) {
+    const StoreAge* left = a;
+    const StoreAge* right = b;
+    if (left->used != right->used) return left->used < right->used ? -1 : 1;
+    return left->index < right->index ? -1 : left->index > right->index;
+}
+
+static void maybe_compact(ThumbnailStore* store) {
+    // Garbage is reclaimed once it outweighs live data, or sooner when the
+    // pack has grown past the budget
+    uint64_t garbage = store->pack_size - store->live_bytes;
+    if (store->compacting || garbage < STORE_MIN_GARBAGE ||
+        (garbage < store->live_bytes && store->pack_size <= store->budget)) {
+        return;
+    }
+
+    // Reap the previous compactor, which has already finished
+    if (store->compactor) {
+        SDL_WaitThread(store->compactor, NULL);
+        store->compactor = NULL;
+    }
+
+    store->compacting = true;
+    store->compactor = SDL_CreateThread(compact_thread, "thumbnail_compact", store);
+    if (!store->compactor) store->compacting = false;
+}
+
+static int compact_thread(void* arg) {
+    ThumbnailStore* store = arg;
+
+    // Records are never modified once written, so the bulk of the copy can
+    // run from a snapshot while workers keep appending to the old pack
+    SDL_LockMutex(store->lock);
+    size_t snapshot_count = store->count;
+    StoreEntry* snapshot = malloc((snapshot_count + 1) * sizeof(StoreEntry));
+    if (snapshot) memcpy(snapshot, store->entries, snapshot_count * sizeof(StoreEntry));
+    SDL_UnlockMutex(store->lock);
+
+    char* temp_path = path_with_suffix(store->pack_path, ".tmp");
+    FILE* in = fopen(store->pack_path, "rb");
+    FILE* out = temp_path ? fopen(temp_path, "w+b") : NULL;
+    uint64_t* offsets = malloc((snapshot_count + 1) * sizeof(uint64_t));
+    uint64_t size = 0;
+
+    bool ok = snapshot && in && out && offsets;
+    for (size_t i = 0; ok && i < snapshot_count; i++) {
+        offsets[i] = size;
+        ok = copy_record(in, out, snapshot[i].offset, snapshot[i].size);
+        size += record_bytes(snapshot[i].size);
+    }
+
+    SDL_LockMutex(store->lock);
+
+    // Catch up on keys written since the snapshot, then swap packs
+    if (ok && store->count > snapshot_count) {
+        uint64_t* grown = realloc(offsets, store->count * sizeof(uint64_t));
+        if (grown) offsets = grown;
+        else ok = false;
+    }
+    for (size_t i = 0; ok && i < store->count; i++) {
+        StoreEntry* entry = &store->entries[i];
+        if (i < snapshot_count && entry->offset == snapshot[i].offset) continue;
+
+        offsets[i] = size;
+        ok = copy_record(in, out, entry->offset, entry->size);
+        size += record_bytes(entry->size);
+    }
+    if (out && fclose(out) != 0) ok = false;
+    if (in) fclose(in);
+
+    if (ok) {
+        fclose(store->pack);
+        remove(store->pack_path);
+        ok = rename(temp_path, store->pack_path) == 0;
+        store->pack = fopen(store->pack_path, "r+b");
+    }
+
+    if (ok && store->pack) {
+        // Records re-copied in the catch-up left their first copies behind
+        // in the new pack, so live bytes come from the index, not its size
+        store->live_bytes = 0;
+        for (size_t i = 0; i < store->count; i++) {
+            store->entries[i].offset = offsets[i];
+            store->live_bytes += record_bytes(store->entries[i].size);
+        }
+        store->pack_size = size;
+        write_index(store);
+    } else if (!store->pack) {
+        // The old pack is gone; start over with an empty one
+        reset_entries(store);
+        store->pack = fopen(store->pack_path, "w+b");
+        store->pack_size = 0;
+    } else if (temp_path) {
+        remove(temp_path);
+    }
+
+    store->compacting = false;
+    SDL_UnlockMutex(store->lock);
+
+    free(offsets);
+    free(snapshot);
+    free(temp_path);
+    return 0;
+}
+
+static bool copy_record(FILE* from, FILE* to, uint64_t offset, uint32_t size) {
+    unsigned char buffer[8192];
+    uint64_t left = record_bytes(size);
+
+    if (fseek(from, (long)offset, SEEK_SET) != 0) return false;
+    while (left > 0) {
+        size_t chunk = left < sizeof(buffer) ? (size_t)left : sizeof(buffer);
+        if (fread(buffer, chunk, 1, from) != 1 || fwrite(buffer, chunk, 1, to) != 1) {
+            return false;
+        }
+        left -= chunk;
+    }
+    return true;
+}
+
+static char* path_with_suffix(const char* path, const char* suffix) {
+    char* result = malloc(strlen(path) + strlen(suffix) + 1);
+    if (result) sprintf(result, "%s%s", path, suffix);
+    return result;
+}
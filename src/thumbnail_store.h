@@ -0,0 +1,65 @@
+#ifndef THUMBNAIL_STORE_H
+#define THUMBNAIL_STORE_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "network.h"
+
+struct ThumbnailStore;
+typedef struct ThumbnailStore ThumbnailStore;
+
+// Thumbnail store counters
+typedef struct {
+    Uint64 hits;            // Lookups that found a record
+    Uint64 misses;
+    Uint64 revalidated;     // Stale records confirmed unchanged by a 304
+    Uint64 refreshed;       // Records replaced by a newer download
+    Uint64 shared;          // Downloads already stored under another URL, counted by the loader
+    Uint64 evictions;
+    uint64_t bytes;         // Live record bytes
+    size_t entries;
+    size_t aliases;         // URLs mapped to a logo
+} ThumbnailStoreStats;
+
+// On-disk thumbnail store
+//
+// Prescaled RGBA32 logos are appended zlib-compressed to a single pack file
+// and located through an in-memory index keyed by a 64-bit hash of their
+// pixels, so a logo served under many URLs is stored once. The
+// index is written next to the pack every few dozen appends and on close,
+// and read back with one sequential read on open; records appended after
+// the last index write are recovered by scanning the pack tail. Rewriting a key leaves its old record
+// as garbage, and once garbage outweighs live data a background thread
+// copies the live records into a fresh pack.
+//
+// Records keep the ETag and Last-Modified of their download so stale logos
+// can be revalidated; thumbnail_store_touch marks one fresh again and keeps
+// any validators the 304 refreshed. When live bytes exceed the budget the
+// least recently read records are dropped from the index and reclaimed by
+// the next compaction.
+//
+// An alias map from 64-bit URL hashes to content hashes leads to the record
+// of each URL. It is appended to its own file as aliases are learned and
+// rewritten without dead pairs on close. All functions are thread safe;
+// thumbnail_store_try_alias and thumbnail_store_try_get_stats return false
+// instead of waiting for the lock.
+ThumbnailStore* thumbnail_store_open(const char* pack_path, const char* index_path,
+                                     const char* alias_path);
+void thumbnail_store_close(ThumbnailStore* store);
+SDL_Surface* thumbnail_store_read(ThumbnailStore* store, uint64_t key, time_t* stored,
+                                  NetworkValidators* validators);
+bool thumbnail_store_write(ThumbnailStore* store, uint64_t key, SDL_Surface* surface,
+                           const NetworkValidators* validators);
+bool thumbnail_store_touch(ThumbnailStore* store, uint64_t key,
+                           const NetworkValidators* validators);
+bool thumbnail_store_contains(ThumbnailStore* store, uint64_t key);
+bool thumbnail_store_alias(ThumbnailStore* store, uint64_t url_key, uint64_t* content);
+bool thumbnail_store_try_alias(ThumbnailStore* store, uint64_t url_key, uint64_t* content);
+void thumbnail_store_set_alias(ThumbnailStore* store, uint64_t url_key, uint64_t content);
+void thumbnail_store_set_budget(ThumbnailStore* store, uint64_t bytes);
+void thumbnail_store_get_stats(ThumbnailStore* store, ThumbnailStoreStats* stats);
+bool thumbnail_store_try_get_stats(ThumbnailStore* store, ThumbnailStoreStats* stats);
+
+#endif // THUMBNAIL_STORE_H
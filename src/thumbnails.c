@@ -1,114 +1,499 @@
-#include <sys/stat.h>
 #include "ui.h"
-#include <SDL2/SDL_image.h>
-#include <curl/curl.h>
+#include "filter_engine.h"
+#include "hash.h"
+#include "profiler.h"
+#include "texture_registry.h"
+#include "thumbnail_loader.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
-#define THUMBNAIL_CACHE_DIR "cache/thumbnails"
-#define THUMBNAIL_MAX_AGE (7 * 24 * 3600)  // 1 week
+static void request_thumbnail(UI* ui, const char* url, bool prefetch);
+static void prefetch_cancelled(void* context, const char* url);
+static bool cache_init(ThumbnailCache* cache);
+static Thumbnail* cache_find(ThumbnailCache* cache, const char* url, uint64_t hash);
+static Thumbnail* cache_claim(ThumbnailCache* cache);
+static void cache_remove(ThumbnailCache* cache, Thumbnail* thumb);
+static ThumbnailCell* cell_find(ThumbnailCache* cache, uint64_t content);
+static ThumbnailCell* cell_acquire(UI* ui, uint64_t content, SDL_Surface* surface);
+static void cell_release(ThumbnailCache* cache, ThumbnailCell* cell);
+static ThumbnailCell* cell_take(ThumbnailCache* cache, bool paged);
+static ThumbnailCell* cell_recycle(ThumbnailCache* cache);
+static bool atlas_add_page(UI* ui, size_t page);
+static bool atlas_upload(UI* ui, ThumbnailCell* cell, SDL_Surface* surface);
+static bool atlas_reclaim(void* context, size_t bytes);
+static void lru_unlink(ThumbnailCache* cache, Thumbnail* thumb);
+static void lru_push_front(ThumbnailCache* cache, Thumbnail* thumb);
 
-static size_t write_data(void *ptr, size_t size, size_t nmemb, FILE *stream) {
-    return fwrite(ptr, size, nmemb, stream);
-}
-
-static char* get_cache_path(const char* url) {
-    char* filename = strrchr(url, '/');
-    if (!filename) filename = (char*)url;
-    else filename++;
-    
-    char* path = malloc(strlen(THUMBNAIL_CACHE_DIR) + strlen(filename) + 2);
-    sprintf(path, "%s/%s", THUMBNAIL_CACHE_DIR, filename);
-    return path;
-}
+SDL_Texture* ui_get_thumbnail(UI* ui, const char* url, SDL_Rect* src) {
+    if (!url || !url[0]) return NULL;
 
-SDL_Texture* ui_get_thumbnail(UI* ui, const char* url) {
-    // Check cache first
-    for (size_t i = 0; i < ui->thumbnail_count; i++) {
-        if (strcmp(ui->thumbnails[i].url, url) == 0) {
-            ui->thumbnails[i].last_access = time(NULL);
-            return ui->thumbnails[i].texture;
+    // Check cache first; entries still loading have no texture yet
+    ThumbnailCache* cache = &ui->thumbnails;
+    Thumbnail* thumb = cache_find(cache, url, hash_string64(FNV64_OFFSET, url));
+    if (thumb) {
+        // Needed now: move a queued prefetch ahead of the other prefetches
+        if (thumb->loading && thumb->prefetch) {
+            thumbnail_loader_promote(ui->thumbnail_loader, url);
+            thumb->prefetch = false;
+        }
+        if (!thumb->loading && cache->head != thumb) {
+            lru_unlink(cache, thumb);
+            lru_push_front(cache, thumb);
         }
+        if (!thumb->cell) return NULL;
+
+        size_t cell = (size_t)(thumb->cell - cache->cells);
+        if (src) *src = thumb->cell->src;
+        return cache->pages[cell / THUMBNAIL_ATLAS_CELLS];
     }
-    
+
     // Load thumbnail
     ui_load_thumbnail(ui, url);
-    return NULL;  // Will be available next frame
+    return NULL;  // Drawn once a worker has decoded it
 }
 
 void ui_load_thumbnail(UI* ui, const char* url) {
-    // Create cache directory if needed
-    mkdir(THUMBNAIL_CACHE_DIR, 0755);
-    
-    char* cache_path = get_cache_path(url);
-    bool needs_download = true;
-    
-    // Check if cached file exists and is fresh
-    struct stat st;
-    if (stat(cache_path, &st) == 0) {
-        if (time(NULL) - st.st_mtime < THUMBNAIL_MAX_AGE) {
-            needs_download = false;
-        }
+    request_thumbnail(ui, url, false);
+}
+
+void ui_prefetch_thumbnails(UI* ui, int first, int visible) {
+    if (!ui->playlist || visible <= 0) return;
+
+    ThumbnailPrefetch* prefetch = &ui->thumbnail_prefetch;
+    Uint32 now = SDL_GetTicks();
+
+    // Smooth over a few frames so one long frame does not swing the window
+    if (prefetch->last_time && now > prefetch->last_time) {
+        float velocity = (first - prefetch->last_first) * 1000.0f / (now - prefetch->last_time);
+        prefetch->velocity = prefetch->velocity * 0.7f + velocity * 0.3f;
     }
-    
-    if (needs_download) {
-        CURL* curl = curl_easy_init();
-        if (curl) {
-            FILE* fp = fopen(cache_path, "wb");
-            if (fp) {
-                curl_easy_setopt(curl, CURLOPT_URL, url);
-                curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_data);
-                curl_easy_setopt(curl, CURLOPT_WRITEDATA, fp);
-                curl_easy_perform(curl);
-                fclose(fp);
-            }
-            curl_easy_cleanup(curl);
+    prefetch->last_first = first;
+    prefetch->last_time = now;
+
+    // Cover the items scrolled past in the next THUMBNAIL_PREFETCH_LEAD ms,
+    // and at least one page, in the direction of travel
+    int count = (int)ui_visible_count(ui);
+    int ahead = (int)(fabsf(prefetch->velocity) * THUMBNAIL_PREFETCH_LEAD / 1000.0f);
+    ahead = MIN(MAX(ahead, visible), THUMBNAIL_PREFETCH_MAX);
+
+    int start, end;
+    if (prefetch->velocity < -0.5f) {
+        start = MAX(0, first - ahead);
+        end = first;
+    } else {
+        start = MIN(count, first + visible);
+        end = MIN(count, start + ahead);
+    }
+
+    if (start == prefetch->window_start && end == prefetch->window_end) return;
+    prefetch->window_start = start;
+    prefetch->window_end = end;
+
+    // Drop everything still queued from the old window; requeueing the
+    // overlap is cheaper than matching it, since nothing has started yet
+    thumbnail_loader_cancel_prefetch(ui->thumbnail_loader, prefetch_cancelled, ui);
+
+    for (int i = start; i < end; i++) {
+        PlaylistItem* item = ui_visible_item(ui, i);
+        if (!item || !item->tvg_logo || !item->tvg_logo[0]) continue;
+
+        const char* url = item->tvg_logo;
+        if (!cache_find(&ui->thumbnails, url, hash_string64(FNV64_OFFSET, url))) {
+            request_thumbnail(ui, url, true);
         }
     }
-    
-    // Load image
-    SDL_Surface* surface = IMG_Load(cache_path);
-    free(cache_path);
-    
-    if (surface) {
-        SDL_Texture* texture = SDL_CreateTextureFromSurface(ui->renderer, surface);
-        SDL_FreeSurface(surface);
-        
-        if (texture) {
-            // Add to cache
-            if (ui->thumbnail_count >= MAX_THUMBNAILS) {
-                // Remove least recently used thumbnail
-                time_t oldest = time(NULL);
-                size_t oldest_idx = 0;
-                
-                for (size_t i = 0; i < ui->thumbnail_count; i++) {
-                    if (ui->thumbnails[i].last_access < oldest) {
-                        oldest = ui->thumbnails[i].last_access;
-                        oldest_idx = i;
-                    }
-                }
-                
-                free(ui->thumbnails[oldest_idx].url);
-                SDL_DestroyTexture(ui->thumbnails[oldest_idx].texture);
-                
-                // Move last item to removed position
-                if (oldest_idx < ui->thumbnail_count - 1) {
-                    ui->thumbnails[oldest_idx] = ui->thumbnails[ui->thumbnail_count - 1];
-                }
-                ui->thumbnail_count--;
+}
+
+static void request_thumbnail(UI* ui, const char* url, bool prefetch) {
+    ThumbnailCache* cache = &ui->thumbnails;
+    if (!cache->entries && !cache_init(cache)) return;
+
+    if (!ui->thumbnail_loader) {
+        ui->thumbnail_loader = thumbnail_loader_create(THUMBNAIL_WORKERS);
+        if (!ui->thumbnail_loader) return;
+    }
+
+    // Every entry is waiting on a worker: ask again on a later frame
+    Thumbnail* thumb = cache_claim(cache);
+    if (!thumb) return;
+
+    thumb->url = strdup(url);
+    if (!thumb->url) {
+        thumb->chain = cache->free_list;
+        cache->free_list = thumb;
+        return;
+    }
+
+    // The entry marks the request in flight, so later lookups of the same
+    // URL wait for it instead of queueing it again
+    thumb->hash = hash_string64(FNV64_OFFSET, url);
+
+    // A URL already known to serve a logo that is on screen under another
+    // URL needs no worker at all
+    uint64_t content;
+    if (thumbnail_loader_lookup(ui->thumbnail_loader, url, &content)) {
+        thumb->cell = cell_find(cache, content);
+        if (thumb->cell) thumb->cell->refs++;
+    }
+
+    thumb->loading = !thumb->cell &&
+                     thumbnail_loader_submit(ui->thumbnail_loader, url, prefetch);
+    thumb->prefetch = prefetch && thumb->loading;
+
+    Thumbnail** bucket = &cache->buckets[thumb->hash & (cache->bucket_count - 1)];
+    thumb->chain = *bucket;
+    *bucket = thumb;
+    cache->count++;
+
+    if (thumb->loading) {
+        ui->thumbnail_pending++;
+    } else {
+        lru_push_front(cache, thumb);
+    }
+}
+
+void ui_upload_thumbnails(UI* ui) {
+    if (!ui->thumbnail_loader || ui->thumbnail_pending == 0) return;
+
+    Uint64 start = profiler_begin();
+
+    // Texture uploads are the only part left on the render thread; cap them
+    // so a burst of finished downloads is spread over several frames
+    char* url;
+    SDL_Surface* surface;
+    uint64_t content;
+    for (int uploads = 0; uploads < THUMBNAIL_UPLOADS_PER_FRAME &&
+         thumbnail_loader_poll(ui->thumbnail_loader, &url, &surface, &content); uploads++) {
+        ui->thumbnail_pending--;
+
+        // Failed loads keep their entry without a texture, so the URL is not
+        // retried every frame until it is evicted
+        // The entry joins the LRU list only once it has a cell, so finding
+        // one can never evict the entry itself
+        Thumbnail* thumb = cache_find(&ui->thumbnails, url, hash_string64(FNV64_OFFSET, url));
+        if (thumb && thumb->loading) {
+            thumb->loading = false;
+            thumb->prefetch = false;
+            if (surface) {
+                thumb->cell = cell_acquire(ui, content, surface);
+                if (thumb->cell) ui_invalidate(ui, UI_DIRTY_THUMBNAILS);
             }
-            
-            // Add new thumbnail
-            ui->thumbnails[ui->thumbnail_count].url = strdup(url);
-            ui->thumbnails[ui->thumbnail_count].texture = texture;
-            ui->thumbnails[ui->thumbnail_count].last_access = time(NULL);
-            ui->thumbnail_count++;
+            lru_push_front(&ui->thumbnails, thumb);
         }
+
+        if (surface) SDL_FreeSurface(surface);
+        free(url);
     }
+
+    profiler_end(PROFILER_PHASE_THUMBNAILS, start);
 }
 
 void ui_cleanup_thumbnails(UI* ui) {
-    for (size_t i = 0; i < ui->thumbnail_count; i++) {
-        free(ui->thumbnails[i].url);
-        SDL_DestroyTexture(ui->thumbnails[i].texture);
+    // Stop the workers first so no result arrives for a freed entry
+    thumbnail_loader_free(ui->thumbnail_loader);
+    ui->thumbnail_loader = NULL;
+    ui->thumbnail_pending = 0;
+
+    ThumbnailCache* cache = &ui->thumbnails;
+    texture_registry_set_reclaimer(TEXTURE_CLASS_THUMBNAIL, NULL, NULL);
+    if (cache->entries) {
+        for (size_t i = 0; i < MAX_THUMBNAILS; i++) {
+            free(cache->entries[i].url);
+        }
+    }
+    if (cache->pages) {
+        for (size_t i = 0; i < THUMBNAIL_ATLAS_PAGES; i++) {
+            texture_registry_destroy(cache->pages[i]);
+        }
+    }
+
+    free(cache->pages);
+    free(cache->entries);
+    free(cache->cells);
+    free(cache->buckets);
+    free(cache->cell_buckets);
+    memset(cache, 0, sizeof(ThumbnailCache));
+}
+
+static void prefetch_cancelled(void* context, const char* url) {
+    UI* ui = context;
+
+    // Forget the entry so the URL can be requested again when it is needed
+    Thumbnail* thumb = cache_find(&ui->thumbnails, url, hash_string64(FNV64_OFFSET, url));
+    if (thumb && thumb->loading) {
+        cache_remove(&ui->thumbnails, thumb);
+        ui->thumbnail_pending--;
+    }
+}
+
+static bool cache_init(ThumbnailCache* cache) {
+    // Twice as many buckets as entries keeps chains short
+    size_t bucket_count = 1;
+    while (bucket_count < MAX_THUMBNAILS * 2) {
+        bucket_count <<= 1;
+    }
+
+    cache->entries = calloc(MAX_THUMBNAILS, sizeof(Thumbnail));
+    cache->cells = calloc(MAX_THUMBNAILS, sizeof(ThumbnailCell));
+    cache->buckets = calloc(bucket_count, sizeof(Thumbnail*));
+    cache->cell_buckets = calloc(bucket_count, sizeof(ThumbnailCell*));
+    cache->pages = calloc(THUMBNAIL_ATLAS_PAGES, sizeof(SDL_Texture*));
+    if (!cache->entries || !cache->cells || !cache->buckets || !cache->cell_buckets ||
+        !cache->pages) {
+        free(cache->entries);
+        free(cache->cells);
+        free(cache->buckets);
+        free(cache->cell_buckets);
+        free(cache->pages);
+        memset(cache, 0, sizeof(ThumbnailCache));
+        return false;
+    }
+
+    cache->bucket_count = bucket_count;
+    for (size_t i = MAX_THUMBNAILS; i > 0; i--) {
+        cache->entries[i - 1].chain = cache->free_list;
+        cache->free_list = &cache->entries[i - 1];
+        cache->cells[i - 1].chain = cache->free_cells;
+        cache->free_cells = &cache->cells[i - 1];
+    }
+    return true;
+}
+
+static Thumbnail* cache_find(ThumbnailCache* cache, const char* url, uint64_t hash) {
+    if (!cache->buckets) return NULL;
+
+    for (Thumbnail* thumb = cache->buckets[hash & (cache->bucket_count - 1)];
+         thumb; thumb = thumb->chain) {
+        if (thumb->hash == hash && strcmp(thumb->url, url) == 0) {
+            return thumb;
+        }
+    }
+    return NULL;
+}
+
+static Thumbnail* cache_claim(ThumbnailCache* cache) {
+    // Pool exhausted: evict the least recently used loaded entry
+    if (!cache->free_list) {
+        if (!cache->tail) return NULL;
+        cache_remove(cache, cache->tail);
+    }
+
+    Thumbnail* thumb = cache->free_list;
+    cache->free_list = thumb->chain;
+    memset(thumb, 0, sizeof(Thumbnail));
+    return thumb;
+}
+
+static void cache_remove(ThumbnailCache* cache, Thumbnail* thumb) {
+    Thumbnail** link = &cache->buckets[thumb->hash & (cache->bucket_count - 1)];
+    while (*link != thumb) {
+        link = &(*link)->chain;
+    }
+    *link = thumb->chain;
+
+    // Entries in flight were never put on the LRU list
+    if (!thumb->loading) lru_unlink(cache, thumb);
+    cache->count--;
+
+    if (thumb->cell) cell_release(cache, thumb->cell);
+    free(thumb->url);
+    thumb->cell = NULL;
+    thumb->url = NULL;
+
+    thumb->chain = cache->free_list;
+    cache->free_list = thumb;
+}
+
+static ThumbnailCell* cell_find(ThumbnailCache* cache, uint64_t content) {
+    for (ThumbnailCell* cell = cache->cell_buckets[content & (cache->bucket_count - 1)];
+         cell; cell = cell->chain) {
+        if (cell->content == content) return cell;
+    }
+    return NULL;
+}
+
+static ThumbnailCell* cell_acquire(UI* ui, uint64_t content, SDL_Surface* surface) {
+    ThumbnailCache* cache = &ui->thumbnails;
+
+    // Another URL already put the same logo in the atlas
+    ThumbnailCell* cell = cell_find(cache, content);
+    if (cell) {
+        cell->refs++;
+        return cell;
+    }
+
+    // Fill the pages that exist before creating another. The cell is taken
+    // off the free list first: creating a page may drop an empty one, which
+    // is where the next free cells would come from
+    cell = cell_take(cache, true);
+    if (!cell) {
+        cell = cell_take(cache, false);
+        if (cell && !atlas_add_page(ui, (size_t)(cell - cache->cells) / THUMBNAIL_ATLAS_CELLS)) {
+            cell->chain = cache->free_cells;
+            cache->free_cells = cell;
+            cell = NULL;
+        }
+    }
+
+    // No room for another page: the least recently used logo gives up its cell
+    if (!cell) cell = cell_recycle(cache);
+    if (!cell) return NULL;
+
+    if (!atlas_upload(ui, cell, surface)) {
+        cell->chain = cache->free_cells;
+        cache->free_cells = cell;
+        return NULL;
+    }
+
+    ThumbnailCell** bucket = &cache->cell_buckets[content & (cache->bucket_count - 1)];
+    cell->content = content;
+    cell->refs = 1;
+    cell->chain = *bucket;
+    *bucket = cell;
+    return cell;
+}
+
+static void cell_release(ThumbnailCache* cache, ThumbnailCell* cell) {
+    if (--cell->refs > 0) return;
+
+    ThumbnailCell** link = &cache->cell_buckets[cell->content & (cache->bucket_count - 1)];
+    while (*link != cell) {
+        link = &(*link)->chain;
+    }
+    *link = cell->chain;
+
+    // The pixels stay in the atlas and are overwritten on reuse
+    cell->chain = cache->free_cells;
+    cache->free_cells = cell;
+}
+
+static ThumbnailCell* cell_take(ThumbnailCache* cache, bool paged) {
+    // Free cells on pages that do not exist yet are skipped when paged
+    ThumbnailCell** link = &cache->free_cells;
+    while (paged && *link &&
+           !cache->pages[(size_t)(*link - cache->cells) / THUMBNAIL_ATLAS_CELLS]) {
+        link = &(*link)->chain;
     }
-    ui->thumbnail_count = 0;
-} 
\ No newline at end of file
+
+    ThumbnailCell* cell = *link;
+    if (cell) *link = cell->chain;
+    return cell;
+}
+
+static ThumbnailCell* cell_recycle(ThumbnailCache* cache) {
+    // Evicting an entry frees its cell unless another URL still shares it
+    while (cache->tail) {
+        ThumbnailCell* cell = cache->tail->cell;
+        cache_remove(cache, cache->tail);
+        if (cell && cell->refs == 0) {
+            // cell_release put it at the head of the free list
+            cache->free_cells = cell->chain;
+            return cell;
+        }
+    }
+    return NULL;
+}
+
+static bool atlas_add_page(UI* ui, size_t page) {
+    ThumbnailCache* cache = &ui->thumbnails;
+
+    // Pages are created as the pool fills, so a small playlist uses one.
+    // Reclaiming for the new page may take other classes' textures or empty
+    // pages, but never logos: evicting them to grow the atlas would only
+    // move the same logos between pages
+    texture_registry_set_reclaimer(TEXTURE_CLASS_THUMBNAIL, atlas_reclaim, ui);
+    cache->growing = true;
+    cache->pages[page] = texture_registry_create(ui->renderer, TEXTURE_CLASS_THUMBNAIL,
+                                                 SDL_PIXELFORMAT_RGBA32,
+                                                 SDL_TEXTUREACCESS_STATIC,
+                                                 THUMBNAIL_ATLAS_SIZE, THUMBNAIL_ATLAS_SIZE);
+    cache->growing = false;
+    if (!cache->pages[page]) return false;
+
+    SDL_SetTextureBlendMode(cache->pages[page], SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+static bool atlas_upload(UI* ui, ThumbnailCell* cell, SDL_Surface* surface) {
+    ThumbnailCache* cache = &ui->thumbnails;
+    size_t index = (size_t)(cell - cache->cells);
+    size_t page = index / THUMBNAIL_ATLAS_CELLS;
+    index %= THUMBNAIL_ATLAS_CELLS;
+
+    // Workers hand over RGBA32 surfaces that already fit a cell
+    SDL_Rect src = {
+        (int)(index % THUMBNAIL_ATLAS_COLUMNS) * THUMBNAIL_WIDTH,
+        (int)(index / THUMBNAIL_ATLAS_COLUMNS) * THUMBNAIL_HEIGHT,
+        MIN(surface->w, THUMBNAIL_WIDTH),
+        MIN(surface->h, THUMBNAIL_HEIGHT)
+    };
+    if (SDL_UpdateTexture(cache->pages[page], &src, surface->pixels, surface->pitch) != 0) {
+        return false;
+    }
+
+    cell->src = src;
+    return true;
+}
+
+static bool atlas_reclaim(void* context, size_t bytes) {
+    UI* ui = context;
+    ThumbnailCache* cache = &ui->thumbnails;
+    (void)bytes;
+
+    // Cells in use per page
+    size_t refs[THUMBNAIL_ATLAS_PAGES] = {0};
+    for (size_t i = 0; i < MAX_THUMBNAILS; i++) {
+        refs[i / THUMBNAIL_ATLAS_CELLS] += cache->cells[i].refs > 0;
+    }
+
+    // A page no logo uses any more goes first, at no cost
+    for (size_t page = 0; page < THUMBNAIL_ATLAS_PAGES; page++) {
+        if (cache->pages[page] && refs[page] == 0) {
+            texture_registry_destroy(cache->pages[page]);
+            cache->pages[page] = NULL;
+            return true;
+        }
+    }
+    if (cache->growing) return false;
+
+    // Evict the least recently used logos until one page is empty. Logos on
+    // screen were drawn last, so they go only once nothing else is left
+    bool evicted = false;
+    while (cache->tail) {
+        ThumbnailCell* cell = cache->tail->cell;
+        cache_remove(cache, cache->tail);
+        evicted = true;
+        if (!cell || cell->refs > 0) continue;
+
+        size_t page = (size_t)(cell - cache->cells) / THUMBNAIL_ATLAS_CELLS;
+        if (--refs[page] == 0) {
+            texture_registry_destroy(cache->pages[page]);
+            cache->pages[page] = NULL;
+            ui_invalidate(ui, UI_DIRTY_THUMBNAILS);
+            return true;
+        }
+    }
+
+    if (evicted) ui_invalidate(ui, UI_DIRTY_THUMBNAILS);
+    return false;
+}
+
+static void lru_unlink(ThumbnailCache* cache, Thumbnail* thumb) {
+    if (thumb->prev) thumb->prev->next = thumb->next;
+    else cache->head = thumb->next;
+
+    if (thumb->next) thumb->next->prev = thumb->prev;
+    else cache->tail = thumb->prev;
+
+    thumb->prev = NULL;
+    thumb->next = NULL;
+}
+
+static void lru_push_front(ThumbnailCache* cache, Thumbnail* thumb) {
+    thumb->prev = NULL;
+    thumb->next = cache->head;
+    if (cache->head) cache->head->prev = thumb;
+    cache->head = thumb;
+    if (!cache->tail) cache->tail = thumb;
+}
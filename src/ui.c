@@ -1,11 +1,26 @@
 #include "ui.h"
+#include "animations.h"
 #include "drawing.h"
+#include "filter_engine.h"
+#include "keyboard.h"
+#include "network.h"
+#include "search.h"
+#include "profiler.h"
+#include "render_batch.h"
+#include "text_renderer.h"
+#include <switch.h>
 #include <SDL2/SDL_ttf.h>
+#include <stdlib.h>
+#include <string.h>
 
 typedef struct {
     UI* ui;
 } UIManager;
 
+static Uint32 ui_idle_timeout(UI* ui);
+static bool ui_open_fonts(UI* ui);
+static AnimationType ui_transition_for(UIState from, UIState to);
+
 UIManager* ui_manager_create(void) {
     UIManager* manager = (UIManager*)malloc(sizeof(UIManager));
     if (!manager) return NULL;
@@ -35,4 +50,224 @@ void ui_manager_run(UIManager* manager) {
 
 UI* ui_manager_get_ui(UIManager* manager) {
     return manager ? manager->ui : NULL;
-} 
\ No newline at end of file
+} 
+
+UI* ui_create(void) {
+    UI* ui = calloc(1, sizeof(UI));
+    if (!ui) return NULL;
+    
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMECONTROLLER) != 0) {
+        free(ui);
+        return NULL;
+    }
+    if (TTF_Init() != 0) {
+        SDL_Quit();
+        free(ui);
+        return NULL;
+    }
+    
+    // From here on ui_free undoes whatever was set up
+    ui->window = SDL_CreateWindow("IPTV Player", SDL_WINDOWPOS_UNDEFINED,
+                                  SDL_WINDOWPOS_UNDEFINED, WINDOW_WIDTH, WINDOW_HEIGHT, 0);
+    if (ui->window) {
+        ui->renderer = SDL_CreateRenderer(ui->window, -1,
+                                          SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
+    }
+    if (!ui->renderer || !ui_open_fonts(ui)) {
+        ui_free(ui);
+        return NULL;
+    }
+    
+    // Input arrives as controller events; SDL closes them on quit
+    for (int i = 0; i < SDL_NumJoysticks(); i++) {
+        if (SDL_IsGameController(i)) SDL_GameControllerOpen(i);
+    }
+    
+    ui->state = UI_STATE_PLAYLIST;
+    ui->grid_rows = DEFAULT_GRID_ROWS;
+    ui->grid_columns = DEFAULT_GRID_COLS;
+    search_init(&ui->search);
+    keyboard_init(ui);
+    
+    // Optional: without it the keyboard just offers no suggestions
+    ui->keyboard.history = search_history_create();
+    
+    ui->playlist = playlist_create();
+    ui->category_filter = category_filter_create();
+    ui->player = player_create();
+    if (!ui->keyboard.text || !ui->playlist || !ui->category_filter || !ui->player) {
+        ui_free(ui);
+        return NULL;
+    }
+    
+    // Offline still works; logos then come only from the store
+    network_init();
+    
+    ui_update_categories(ui);
+    return ui;
+}
+
+void ui_free(UI* ui) {
+    if (!ui) return;
+    
+    // Playback and search threads first, so nothing still running sees
+    // freed state
+    player_free(ui->player);
+    search_shutdown(ui);
+    
+    // Joins the logo workers and saves the store's index
+    ui_cleanup_thumbnails(ui);
+    
+    animation_shutdown(ui);
+    text_renderer_shutdown();
+    render_batch_shutdown();
+    
+    filter_engine_free(ui->filter_engine);
+    category_filter_free(ui->category_filter);
+    category_index_free(&ui->category_index);
+    for (int i = 0; i < ui->category_count; i++) {
+        free(ui->categories[i]);
+    }
+    free(ui->categories);
+    
+    search_history_free(ui->keyboard.history);
+    free(ui->keyboard.text);
+    free(ui->status_message);
+    epg_free(ui->epg);
+    playlist_free(ui->playlist);
+    
+    if (ui->font) TTF_CloseFont(ui->font);
+    if (ui->font_large) TTF_CloseFont(ui->font_large);
+    if (ui->renderer) SDL_DestroyRenderer(ui->renderer);
+    if (ui->window) SDL_DestroyWindow(ui->window);
+    free(ui);
+    
+    network_cleanup();
+    plExit();
+    TTF_Quit();
+    SDL_Quit();
+}
+
+void ui_run(UI* ui) {
+    if (!ui) return;
+    
+    ui_invalidate(ui, UI_DIRTY_ALL);
+    
+    while (!ui->quit) {
+        // Sleep until input arrives or the next timed change is due
+        Uint32 timeout = ui_idle_timeout(ui);
+        if (timeout > 0) {
+            SDL_WaitEventTimeout(NULL, (int)timeout);
+        }
+        
+        profiler_begin_frame();
+        
+        Uint64 start = profiler_begin();
+        ui_handle_input(ui);
+        profiler_end(PROFILER_PHASE_INPUT, start);
+        
+        start = profiler_begin();
+        ui_update(ui);
+        profiler_end(PROFILER_PHASE_UPDATE, start);
+        
+        // Nothing changed: keep the last presented frame
+        bool drawn = ui->dirty != UI_DIRTY_NONE;
+        if (drawn) {
+            ui->dirty = UI_DIRTY_NONE;
+            start = profiler_begin();
+            ui_draw(ui);
+            profiler_end(PROFILER_PHASE_DRAW, start);
+        }
+        
+        profiler_end_frame(drawn);
+    }
+}
+
+void ui_update(UI* ui) {
+    if (!ui) return;
+    
+    // Collect streamed search results without blocking the frame
+    search_poll_results(ui);
+    
+    // Drop the status line once it expires
+    if (ui->status_message && SDL_GetTicks() >= ui->status_timeout) {
+        free(ui->status_message);
+        ui->status_message = NULL;
+        ui_invalidate(ui, UI_DIRTY_STATUS);
+    }
+    
+    animation_update(ui);
+    
+    // Turn decoded logos into textures, a few per frame
+    ui_upload_thumbnails(ui);
+    
+    // Animations, video and the profiler graph change every frame
+    if (ui->animating || ui->state == UI_STATE_PLAYING || profiler_overlay_visible()) {
+        ui_invalidate(ui, UI_DIRTY_ANIMATION);
+    }
+}
+
+void ui_invalidate(UI* ui, Uint32 flags) {
+    if (ui) ui->dirty |= flags;
+}
+
+void ui_set_state(UI* ui, UIState state) {
+    if (!ui || ui->state == state) return;
+    
+    // Captures the outgoing screen, so it must run before the switch
+    animation_start(ui, ui_transition_for(ui->state, state));
+    
+    ui->state = state;
+    ui_invalidate(ui, UI_DIRTY_ALL);
+}
+
+void ui_show_message(UI* ui, const char* message, Uint32 timeout) {
+    if (!ui || !message) return;
+    
+    free(ui->status_message);
+    ui->status_message = strdup(message);
+    ui->status_timeout = SDL_GetTicks() + timeout;
+    ui_invalidate(ui, UI_DIRTY_STATUS);
+}
+
+static Uint32 ui_idle_timeout(UI* ui) {
+    if (ui->dirty) return 0;
+    
+    // Per-frame work keeps the loop at frame rate
+    if (ui->animating || ui->state == UI_STATE_PLAYING || ui->search_pending ||
+        ui->thumbnail_pending > 0 || profiler_overlay_visible()) {
+        return UI_FRAME_INTERVAL;
+    }
+    
+    // Wake up in time to clear the status line
+    Uint32 timeout = UI_IDLE_TIMEOUT;
+    if (ui->status_message) {
+        Uint32 now = SDL_GetTicks();
+        Uint32 left = ui->status_timeout > now ? ui->status_timeout - now : 0;
+        timeout = MIN(timeout, left);
+    }
+    return timeout;
+}
+
+static bool ui_open_fonts(UI* ui) {
+    // The system font is mapped for as long as pl is open; ui_free closes it
+    PlFontData font;
+    if (R_FAILED(plInitialize(PlServiceType_User)) ||
+        R_FAILED(plGetSharedFontByType(&font, PlSharedFontType_Standard))) {
+        return false;
+    }
+    
+    ui->font = TTF_OpenFontRW(SDL_RWFromConstMem(font.address, (int)font.size), 1, 24);
+    ui->font_large = TTF_OpenFontRW(SDL_RWFromConstMem(font.address, (int)font.size), 1, 36);
+    return ui->font && ui->font_large;
+}
+
+static AnimationType ui_transition_for(UIState from, UIState to) {
+    // The player's thread presents the video, so playback cuts in and out
+    if (from == UI_STATE_PLAYING || to == UI_STATE_PLAYING) return ANIM_NONE;
+    
+    // Categories sit one level above the playlist
+    if (to == UI_STATE_CATEGORIES) return ANIM_SLIDE_RIGHT;
+    if (from == UI_STATE_CATEGORIES) return ANIM_SLIDE_LEFT;
+    return ANIM_FADE;
+}
@@ -6,14 +6,23 @@
 #include <stdbool.h>
 #include "player.h"
 #include "playlist.h"
+#include "playlist_sort.h"
+#include "result_set.h"
 #include "epg.h"
 #include "ui_constants.h"
 #include "category_blocker.h"
 #include "categories.h"
+#include "list_view.h"
 
 // Forward declarations
 struct UI;
 typedef struct UI UI;
+struct SearchWorker;
+typedef struct SearchWorker SearchWorker;
+struct ThumbnailLoader;
+typedef struct ThumbnailLoader ThumbnailLoader;
+struct FilterEngine;
+typedef struct FilterEngine FilterEngine;
 
 // UI States
 typedef enum {
@@ -29,7 +38,8 @@ typedef enum {
     ANIM_FADE,
     ANIM_ZOOM,
     ANIM_SLIDE_LEFT,
-    ANIM_SLIDE_RIGHT
+    ANIM_SLIDE_RIGHT,
+    ANIM_NONE         // Cut without a transition
 } AnimationType;
 
 // Player settings
@@ -44,38 +54,111 @@ typedef struct {
 typedef struct {
     char query[256];
     bool show_favorites_only;
-    PlaylistItem** results;
-    size_t result_count;
+    ResultSet results;  // Indices into playlist->items
+    ItemBitmap filter;  // Items the search may return, kept off the shared engine
     char* selected_category;
+    PlaylistSortKey sort_key;
 } SearchContext;
 
 // Animation transition
+//
+// prev_screen and next_screen are render targets kept for the lifetime of
+// the UI. Each side is captured once per transition and composited with a
+// single copy per frame.
 typedef struct {
     AnimationType type;
+    AnimationType effect;     // type, or a cheaper one when frames run long
     float duration;
     float progress;
     Uint32 start_time;
+    Uint32 last_frame;
     SDL_Texture* prev_texture;
     SDL_Texture* prev_screen;
     SDL_Texture* next_screen;
+    bool next_captured;
 } Transition;
 
+// Atlas cell holding one decoded logo
+typedef struct ThumbnailCell {
+    uint64_t content;         // Hash of the prescaled pixels
+    SDL_Rect src;             // Logo within its atlas page
+    uint32_t refs;            // Entries showing this logo
+    struct ThumbnailCell* chain;  // Hash bucket, or the free list
+} ThumbnailCell;
+
 // Thumbnail structure
-typedef struct {
-    SDL_Texture* texture;
+typedef struct Thumbnail {
+    ThumbnailCell* cell;      // Shared with other URLs of the same logo
     char* url;
-    time_t last_access;
+    uint64_t hash;
     bool loading;
+    bool prefetch;            // Queued ahead of scrolling, at low priority
+    
+    struct Thumbnail* chain;  // Hash bucket, or the free list
+    struct Thumbnail* prev;   // Towards most recently used
+    struct Thumbnail* next;   // Towards least recently used
 } Thumbnail;
 
-// Search history
+// Thumbnail cache
+//
+// Entries come from a fixed pool and are found through a hash table on the
+// URL. Loaded entries sit on an LRU list and the tail is evicted when the
+// pool runs out. Entries still loading stay off the list, so they are never
+// evicted under a worker.
+//
+// Logos are stored prescaled in atlas pages of THUMBNAIL_ATLAS_SIZE squared,
+// split into tile-sized cells. Cells are keyed by a hash of their pixels, so
+// every URL serving the same image shares one cell; a cell is freed when the
+// last entry referencing it is evicted. Pages are added while the texture
+// budget allows; past that, a new logo takes the cell of the least recently
+// used one, and reclaiming for other textures evicts logos in LRU order until
+// a page is empty.
 typedef struct {
-    char** items;
+    Thumbnail* entries;
+    ThumbnailCell* cells;     // Cell i is tile i of the atlas, across pages
+    SDL_Texture** pages;
+    Thumbnail* free_list;
+    ThumbnailCell* free_cells;
+    Thumbnail** buckets;      // By URL hash
+    ThumbnailCell** cell_buckets;  // By content hash
+    size_t bucket_count;
+    Thumbnail* head;          // Most recently used
+    Thumbnail* tail;          // Least recently used
+    size_t count;
+    bool growing;             // Creating a page, which must not evict logos
+} ThumbnailCache;
+
+// Thumbnail prefetch state
+//
+// Tracks how fast the first visible item moves and keeps the logos of the
+// items the view is heading towards queued at low priority.
+typedef struct {
+    int last_first;
+    Uint32 last_time;
+    float velocity;           // Items per second, negative scrolling up
+    int window_start;         // Items currently prefetched
+    int window_end;
+} ThumbnailPrefetch;
+
+// Search history entry
+typedef struct {
+    char* query;
+    double score;      // Use count, decayed as of last_used
+    time_t last_used;
+    double rank;       // Time-invariant ordering key derived from score
+} SearchHistoryEntry;
+
+// Search history, persisted as an append-only log and loaded on first use
+typedef struct {
+    SearchHistoryEntry* entries;  // Sorted by rank, best first
     size_t count;
     size_t capacity;
     char* input_buffer;
     char** suggestions;
     size_t suggestion_count;
+    char* path;
+    bool loaded;
+    size_t log_records;
 } SearchHistory;
 
 // Keyboard context
@@ -88,6 +171,17 @@ typedef struct {
     SearchHistory* history;
 } KeyboardContext;
 
+// Reasons for a redraw; the frame is skipped while none are set
+typedef enum {
+    UI_DIRTY_NONE = 0,
+    UI_DIRTY_INPUT = 1 << 0,        // Selection, scroll, text entry
+    UI_DIRTY_CONTENT = 1 << 1,      // Playlist, filters, search results
+    UI_DIRTY_STATUS = 1 << 2,       // Status message shown or expired
+    UI_DIRTY_THUMBNAILS = 1 << 3,   // Thumbnail arrived
+    UI_DIRTY_ANIMATION = 1 << 4,    // Animation or video frame
+    UI_DIRTY_ALL = 0xFF
+} UIDirtyFlags;
+
 // UI Context
 typedef struct UI {
     // Window and rendering
@@ -99,6 +193,7 @@ typedef struct UI {
     // State
     UIState state;
     bool quit;
+    Uint32 dirty;  // UIDirtyFlags
     
     // Player
     Player* player;
@@ -108,17 +203,22 @@ typedef struct UI {
     Playlist* playlist;
     int selected_item;
     int scroll_offset;
+    ListView playlist_view;
     
     // Categories
     CategoryFilter* category_filter;
+    FilterEngine* filter_engine;
     int selected_category;
     int category_count;
     char** categories;
+    CategoryIndex category_index;  // Dense ids and per-category item lists
+    ListView category_view;
     
     // Search
     SearchContext search;
-    PlaylistItem** search_results;
-    size_t search_result_count;
+    SearchWorker* search_worker;
+    Uint32 search_generation;
+    bool search_pending;
     KeyboardContext keyboard;
     
     // Touch input
@@ -141,8 +241,10 @@ typedef struct UI {
     EPGData* epg;
     
     // Thumbnails
-    Thumbnail* thumbnails;
-    size_t thumbnail_count;
+    ThumbnailCache thumbnails;
+    ThumbnailLoader* thumbnail_loader;
+    size_t thumbnail_pending;     // Submitted and not yet collected
+    ThumbnailPrefetch thumbnail_prefetch;
     
     // Grid view
     int grid_rows;
@@ -159,15 +261,26 @@ void ui_free(UI* ui);
 void ui_run(UI* ui);
 void ui_draw(UI* ui);
 void ui_update(UI* ui);
+void ui_invalidate(UI* ui, Uint32 flags);
 void ui_handle_input(UI* ui);
 void ui_set_state(UI* ui, UIState state);
 void ui_show_message(UI* ui, const char* message, Uint32 timeout);
 void ui_draw_status(UI* ui);
+void ui_draw_screen(UI* ui);
 void ui_draw_playlist(UI* ui);
 void ui_draw_player(UI* ui);
 void ui_draw_epg(UI* ui);
+void ui_draw_grid(UI* ui);
+void ui_draw_epg_grid(UI* ui);
 void ui_perform_search(UI* ui);
 
+// Thumbnail functions
+SDL_Texture* ui_get_thumbnail(UI* ui, const char* url, SDL_Rect* src);
+void ui_load_thumbnail(UI* ui, const char* url);
+void ui_prefetch_thumbnails(UI* ui, int first, int visible);
+void ui_upload_thumbnails(UI* ui);
+void ui_cleanup_thumbnails(UI* ui);
+
 // Search history functions
 SearchHistory* search_history_create(void);
 void search_history_free(SearchHistory* history);
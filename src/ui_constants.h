@@ -10,17 +10,41 @@
 #define SCROLL_MARGIN 20
 #define STATUS_DURATION 3000  // 3 seconds
 
+// Main loop timing
+#define UI_FRAME_INTERVAL 16    // While animating or playing
+#define UI_IDLE_TIMEOUT 1000    // Longest sleep waiting for input
+#define UI_FRAME_BUDGET_MS 16.6f
+
+// Transition settings
+#define TRANSITION_DURATION 0.25f  // Seconds
+
 // Helper macros
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
 #define MAX(a,b) ((a) > (b) ? (a) : (b))
 
 // Thumbnail settings
-#define MAX_THUMBNAILS 100
+#define MAX_THUMBNAILS 2048
 #define THUMBNAIL_WIDTH 160
 #define THUMBNAIL_HEIGHT 90
+#define THUMBNAIL_WORKERS 2
+#define THUMBNAIL_UPLOADS_PER_FRAME 4
+#define THUMBNAIL_PREFETCH_LEAD 500    // Milliseconds of scrolling to look ahead
+#define THUMBNAIL_PREFETCH_MAX 48      // Items queued ahead at most
+#define THUMBNAIL_DISK_BUDGET (32 * 1024 * 1024)  // Live bytes in the pack file
+#define THUMBNAIL_ATLAS_SIZE 2048
+#define THUMBNAIL_ATLAS_COLUMNS (THUMBNAIL_ATLAS_SIZE / THUMBNAIL_WIDTH)
+#define THUMBNAIL_ATLAS_CELLS (THUMBNAIL_ATLAS_COLUMNS * (THUMBNAIL_ATLAS_SIZE / THUMBNAIL_HEIGHT))
+#define THUMBNAIL_ATLAS_PAGES ((MAX_THUMBNAILS + THUMBNAIL_ATLAS_CELLS - 1) / THUMBNAIL_ATLAS_CELLS)
+
+// Where the app keeps its own files; the host build uses the working directory
+#ifdef __SWITCH__
+#define APP_DATA_DIR "sdmc:/switch/iptv_player"
+#else
+#define APP_DATA_DIR "."
+#endif
 
 // Search history settings
-#define MAX_SEARCH_HISTORY 20
+#define MAX_SEARCH_HISTORY 200
 #define MAX_SUGGESTIONS 10
 #define MAX_QUERY_LENGTH 256
 #define MAX_INPUT_LENGTH 256
@@ -40,6 +64,12 @@
 #define MAX_BLOCKED_CATEGORIES 50
 #define MAX_CATEGORY_LENGTH 64
 
+// Text cache settings
+#define TEXT_CACHE_BUDGET (4 * 1024 * 1024)  // Bytes of cached text textures
+
+// Texture memory settings
+#define TEXTURE_BUDGET (96 * 1024 * 1024)    // Bytes of all live GPU textures
+
 // Profile settings
 #define MAX_PROFILE_NAME 32
 #define MAX_PIN_LENGTH 8
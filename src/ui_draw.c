@@ -1,13 +1,55 @@
 #include "ui.h"
+#include "animations.h"
 #include "drawing.h"
+#include "filter_engine.h"
+#include "list_view.h"
+#include "profiler.h"
+#include "render_batch.h"
+#include "thumbnail_loader.h"
 #include <SDL2/SDL_ttf.h>
+#include <stdio.h>
+
+#define OVERLAY_NOTES 2
+#define OVERLAY_NOTE_LENGTH 96
+
+static const char* playlist_label(UI* ui, int index, char* buffer, size_t size);
+static int overlay_notes(UI* ui, char notes[][OVERLAY_NOTE_LENGTH]);
 
 void ui_draw(UI* ui) {
     // Clear screen
     SDL_SetRenderDrawColor(ui->renderer, 0, 0, 0, 255);
     SDL_RenderClear(ui->renderer);
     
-    // Draw current state
+    // Draw current state, or the transition into it
+    if (ui->animating) {
+        animation_draw(ui);
+    } else {
+        ui_draw_screen(ui);
+    }
+    
+    // Draw status message if active
+    if (ui->status_message && SDL_GetTicks() < ui->status_timeout) {
+        render_batch_flush(ui->renderer);
+        ui_draw_status(ui);
+    }
+    
+    if (profiler_overlay_visible()) {
+        char notes[OVERLAY_NOTES][OVERLAY_NOTE_LENGTH];
+        const char* lines[OVERLAY_NOTES];
+        int count = overlay_notes(ui, notes);
+        for (int i = 0; i < count; i++) lines[i] = notes[i];
+        profiler_draw_overlay(ui->renderer, ui->font, lines, count);
+    }
+    
+    render_batch_flush(ui->renderer);
+    
+    Uint64 start = profiler_begin();
+    SDL_RenderPresent(ui->renderer);
+    profiler_end(PROFILER_PHASE_PRESENT, start);
+}
+
+void ui_draw_screen(UI* ui) {
+    Uint64 start = profiler_begin();
     switch (ui->state) {
         case UI_STATE_PLAYLIST:
             ui_draw_playlist(ui);
@@ -22,18 +64,115 @@ void ui_draw(UI* ui) {
             break;
             
         case UI_STATE_CATEGORIES:
-            // Use existing category drawing code
+            ui_draw_categories(ui);
             break;
             
         case UI_STATE_SEARCH:
             // Use existing search drawing code
             break;
     }
+    profiler_end(PROFILER_PHASE_DRAW_STATE, start);
+}
+
+void ui_draw_playlist(UI* ui) {
+    if (!ui->playlist) return;
     
-    // Draw status message if active
-    if (ui->status_message && SDL_GetTicks() < ui->status_timeout) {
-        ui_draw_status(ui);
+    SDL_Color white = {255, 255, 255, 255};
+    int count = (int)ui_visible_count(ui);
+    
+    // Rows match the page size used by the input handler
+    ListView* view = &ui->playlist_view;
+    list_view_layout(view, 40, 60, WINDOW_WIDTH - 80, WINDOW_HEIGHT - 120, ITEM_HEIGHT);
+    view->scroll = ui->scroll_offset;
+    list_view_follow(view, ui->selected_item, count);
+    ui->scroll_offset = view->scroll;
+    
+    // Selection bar behind the selected row
+    if (ui->selected_item >= view->scroll &&
+        ui->selected_item < view->scroll + list_view_visible_rows(view)) {
+        SDL_Rect bar = {20, view->bounds.y + (ui->selected_item - view->scroll) * ITEM_HEIGHT - 5,
+                        WINDOW_WIDTH - 40, ITEM_HEIGHT};
+        SDL_Color accent = {0x00, 0xA5, 0xE0, 0xFF};
+        render_batch_rect(ui->renderer, RENDER_LAYER_BACKGROUND, &bar, accent);
     }
     
-    SDL_RenderPresent(ui->renderer);
-} 
\ No newline at end of file
+    list_view_draw(view, ui, count, ui->selected_item, playlist_label);
+    
+    draw_text(ui->renderer, ui->font,
+              "A: Play   B: Categories   L: Favorite   R: Favorites Only   Y: View Mode   X: Search",
+              WINDOW_WIDTH/2, WINDOW_HEIGHT - 30, white, true);
+}
+
+void ui_draw_player(UI* ui) {
+    SDL_Color white = {255, 255, 255, 255};
+
+    // The player's render thread presents the video itself; only the
+    // channel name, or why playback stopped, is drawn here
+    PlayerError error = player_get_last_error(ui->player);
+    if (error != PLAYER_ERROR_NONE) {
+        draw_text(ui->renderer, ui->font_large, player_get_error_string(error),
+                  WINDOW_WIDTH/2, WINDOW_HEIGHT/2 - 20, white, true);
+    } else if (ui->player && ui->player->current_item && ui->player->current_item->title) {
+        draw_text(ui->renderer, ui->font_large, ui->player->current_item->title,
+                  40, 30, white, false);
+    }
+
+    draw_text(ui->renderer, ui->font, "B: Back",
+              WINDOW_WIDTH/2, WINDOW_HEIGHT - 30, white, true);
+}
+
+void ui_draw_epg(UI* ui) {
+    SDL_Color white = {255, 255, 255, 255};
+
+    ui_draw_epg_grid(ui);
+    draw_text(ui->renderer, ui->font, "B: Back",
+              WINDOW_WIDTH/2, WINDOW_HEIGHT - 30, white, true);
+}
+
+void ui_draw_status(UI* ui) {
+    if (!ui->status_message) return;
+
+    // Drawn over the controls line; the screen below was already flushed
+    SDL_Rect bar = {0, WINDOW_HEIGHT - 50, WINDOW_WIDTH, 50};
+    SDL_Color shade = {0, 0, 0, 224};
+    SDL_Color white = {255, 255, 255, 255};
+    render_batch_rect(ui->renderer, RENDER_LAYER_OVERLAY, &bar, shade);
+    draw_text(ui->renderer, ui->font, ui->status_message,
+              WINDOW_WIDTH/2, bar.y + 12, white, true);
+}
+
+static const char* playlist_label(UI* ui, int index, char* buffer, size_t size) {
+    (void)buffer;
+    (void)size;
+    
+    PlaylistItem* item = ui_visible_item(ui, index);
+    return item ? item->title : NULL;
+}
+
+static int overlay_notes(UI* ui, char notes[][OVERLAY_NOTE_LENGTH]) {
+    int count = 0;
+    
+    // Logo store: hits against downloads, stale logos a 304 kept, and
+    // downloads the store already held under another URL
+    ThumbnailStoreStats store;
+    thumbnail_loader_get_stats(ui->thumbnail_loader, &store);
+    snprintf(notes[count++], OVERLAY_NOTE_LENGTH,
+             "logos      %zu  %5.1f MB  hit %llu miss %llu  304 %llu new %llu dup %llu",
+             store.entries, store.bytes / 1048576.0,
+             (unsigned long long)store.hits, (unsigned long long)store.misses,
+             (unsigned long long)store.revalidated, (unsigned long long)store.refreshed,
+             (unsigned long long)store.shared);
+    
+    // A/V sync of the stream on screen, offsets in milliseconds
+    if (ui->state == UI_STATE_PLAYING && ui->player) {
+        PlayerSyncStats sync = player_get_sync_stats(ui->player);
+        snprintf(notes[count++], OVERLAY_NOTE_LENGTH,
+                 "a/v %s  %+6.1f mean %+6.1f max %+6.1f  shown %u drop %u held %u",
+                 sync.audio_clock ? "audio" : "wall ",
+                 sync.av_offset * 1000.0, sync.av_offset_mean * 1000.0,
+                 sync.av_offset_max * 1000.0, (unsigned)sync.frames_presented,
+                 (unsigned)sync.frames_dropped, (unsigned)sync.frames_held);
+    }
+    
+    return count;
+}
@@ -1,5 +1,7 @@
 #include "ui.h"
 #include "ui_constants.h"
+#include "filter_engine.h"
+#include "profiler.h"
 #include <switch.h>
 #include <SDL2/SDL.h>
 
@@ -9,39 +11,64 @@ void ui_handle_input(UI* ui) {
     // Calculate visible items
     int visible_items = (WINDOW_HEIGHT - SCROLL_MARGIN * 2) / ITEM_HEIGHT;
     
+    // Only events that change what is on screen mark it dirty; state
+    // changes, messages and filters invalidate through their own setters
     while (SDL_PollEvent(&event)) {
         switch (event.type) {
             case SDL_QUIT:
                 ui->quit = true;
                 break;
                 
+            case SDL_WINDOWEVENT:
+            case SDL_RENDER_TARGETS_RESET:
+                ui_invalidate(ui, UI_DIRTY_ALL);
+                break;
+                
             case SDL_CONTROLLERBUTTONDOWN:
                 switch (event.cbutton.button) {
                     case SDL_CONTROLLER_BUTTON_DPAD_UP:
-                        if (ui->selected_item > 0) {
+                        if (ui->state == UI_STATE_CATEGORIES) {
+                            if (ui->selected_category > 0) {
+                                ui->selected_category--;
+                                ui_invalidate(ui, UI_DIRTY_INPUT);
+                            }
+                        } else if (ui->selected_item > 0) {
                             ui->selected_item--;
                             if (ui->selected_item < ui->scroll_offset) {
                                 ui->scroll_offset = ui->selected_item;
                             }
+                            ui_invalidate(ui, UI_DIRTY_INPUT);
                         }
                         break;
                         
                     case SDL_CONTROLLER_BUTTON_DPAD_DOWN:
-                        if (ui->playlist && ui->selected_item < (int)ui->playlist->count - 1) {
+                        if (ui->state == UI_STATE_CATEGORIES) {
+                            if (ui->selected_category < ui->category_count - 1) {
+                                ui->selected_category++;
+                                ui_invalidate(ui, UI_DIRTY_INPUT);
+                            }
+                        } else if (ui->playlist && ui->selected_item < (int)ui_visible_count(ui) - 1) {
                             ui->selected_item++;
                             if (ui->selected_item >= ui->scroll_offset + (WINDOW_HEIGHT - 120) / ITEM_HEIGHT) {
                                 ui->scroll_offset = ui->selected_item - (WINDOW_HEIGHT - 120) / ITEM_HEIGHT + 1;
                             }
+                            ui_invalidate(ui, UI_DIRTY_INPUT);
                         }
                         break;
                         
                     case SDL_CONTROLLER_BUTTON_A:
                         if (ui->state == UI_STATE_PLAYLIST && ui->playlist) {
-                            PlaylistItem* item = &ui->playlist->items[ui->selected_item];
-                            if (player_load(ui->player, item)) {
+                            PlaylistItem* item = ui_visible_item(ui, ui->selected_item);
+                            if (item && player_load(ui->player, item)) {
+                                playlist_set_last_played(ui->playlist,
+                                                         (size_t)(item - ui->playlist->items),
+                                                         time(NULL));
                                 player_play(ui->player);
                                 ui_set_state(ui, UI_STATE_PLAYING);
                             }
+                        } else if (ui->state == UI_STATE_CATEGORIES && ui->category_count > 0) {
+                            ui_select_category(ui, ui->selected_category);
+                            ui_set_state(ui, UI_STATE_PLAYLIST);
                         }
                         break;
                         
@@ -49,8 +76,39 @@ void ui_handle_input(UI* ui) {
                         if (ui->state == UI_STATE_PLAYING) {
                             player_stop(ui->player);
                             ui_set_state(ui, UI_STATE_PLAYLIST);
+                        } else if (ui->state == UI_STATE_PLAYLIST) {
+                            ui_set_state(ui, UI_STATE_CATEGORIES);
+                        } else if (ui->state == UI_STATE_CATEGORIES) {
+                            // Back out of the list to every channel
+                            ui_select_category(ui, -1);
+                            ui_set_state(ui, UI_STATE_PLAYLIST);
+                        }
+                        break;
+                        
+                    case SDL_CONTROLLER_BUTTON_LEFTSHOULDER:
+                        if (ui->state == UI_STATE_PLAYLIST) {
+                            PlaylistItem* item = ui_visible_item(ui, ui->selected_item);
+                            if (item) ui_set_favorite(ui, item, !item->favorite);
+                        }
+                        break;
+                        
+                    case SDL_CONTROLLER_BUTTON_RIGHTSHOULDER:
+                        if (ui->state == UI_STATE_PLAYLIST && ui->filter_engine) {
+                            ui_set_favorites_only(ui, !ui->filter_engine->favorites_only);
                         }
                         break;
+                        
+                    case SDL_CONTROLLER_BUTTON_LEFTSTICK:
+                        profiler_toggle_overlay();
+                        ui_invalidate(ui, UI_DIRTY_ALL);
+                        break;
+                        
+                    case SDL_CONTROLLER_BUTTON_RIGHTSTICK:
+                        ui_show_message(ui, profiler_dump(PROFILER_DUMP_FILE)
+                                            ? "Frame profile saved"
+                                            : "Could not save frame profile",
+                                        STATUS_DURATION);
+                        break;
                 }
                 break;
         }